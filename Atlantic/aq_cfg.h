@@ -12,7 +12,8 @@
 #ifndef AQ_CFG_H
 #define AQ_CFG_H
 
-#define AQ_CFG_VECS_DEF   4U
+/* One queue per CPU, limited to the hardware in aq_nic_cfg_start() */
+#define AQ_CFG_VECS_DEF   AQ_CFG_VECS_MAX
 #define AQ_CFG_TCS_DEF    1U
 
 #define AQ_CFG_TXDS_DEF    4096U
@@ -22,11 +23,21 @@
 
 #define AQ_CFG_FORCE_LEGACY_INT 0U
 
+/* Service TX completions from a dedicated MSI-X vector per queue */
+#define AQ_CFG_IS_TX_IRQ_SEPARATE_DEF 0U
+
 #define AQ_CFG_IS_INTERRUPT_MODERATION_DEF   1U
-#define AQ_CFG_INTERRUPT_MODERATION_RATE_DEF 0xFFFFU
+#define AQ_CFG_ITR_AUTO                      0xFFFFU /* by link speed */
+#define AQ_CFG_ITR_USECS_MAX                 1022U
+#define AQ_CFG_INTERRUPT_MODERATION_RATE_DEF AQ_CFG_ITR_AUTO
 #define AQ_CFG_IRQ_MASK                      0x1FFU
 
-#define AQ_CFG_VECS_MAX   8U
+/* Dynamic moderation, re-evaluated every AQ_CFG_DIM_EVENTS interrupts */
+#define AQ_CFG_IS_RX_DIM_DEF 0U
+#define AQ_CFG_IS_TX_DIM_DEF 0U
+#define AQ_CFG_DIM_EVENTS    64U
+
+#define AQ_CFG_VECS_MAX   32U
 #define AQ_CFG_TCS_MAX    8U
 
 #define AQ_CFG_TX_FRAME_MAX  (16U * 1024U)
@@ -43,15 +54,50 @@
 #define AQ_CFG_NUM_RSS_QUEUES_DEF   AQ_CFG_VECS_DEF
 #define AQ_CFG_RSS_BASE_CPU_NUM_DEF 0U
 
-#define AQ_CFG_PCI_FUNC_MSIX_IRQS   9U
+/* Select TX queue from the RSS queue of the flow (ethtool priv flag) */
+#define AQ_CFG_IS_TX_FLOW_AFFINE_DEF 0U
+
+#define AQ_CFG_PCI_FUNC_MSIX_IRQS   32U
 #define AQ_CFG_PCI_FUNC_PORTS       2U
 
 #define AQ_CFG_SERVICE_TIMER_INTERVAL    (2 * HZ)
-#define AQ_CFG_POLLING_TIMER_INTERVAL   ((unsigned int)(2 * HZ))
+
+/* Polling mode: interval of the per vector hrtimer that schedules NAPI,
+ * set with the polling_usecs module parameter
+ */
+#define AQ_CFG_POLLING_USECS_DEF   20U
+#define AQ_CFG_POLLING_USECS_MAX   10000U
 
 #define AQ_CFG_SKB_FRAGS_MAX   32U
 
+/* aq_nic_xmit() tries to reclaim completed descriptors itself when fewer
+ * than this number of descriptors are left in the ring
+ */
+#define AQ_CFG_TX_RECLAIM_THRESHOLD  (2U * AQ_CFG_SKB_FRAGS_MAX)
+
+/* TX doorbell coalescing: tail pointer updates may be deferred by up to
+ * _FRAMES_ descriptors or _USECS_ microseconds. Off by default, set with
+ * the tx_doorbell_frames/tx_doorbell_usecs module parameters.
+ */
+#define AQ_CFG_TX_DOORBELL_FRAMES_DEF  0U
+#define AQ_CFG_TX_DOORBELL_USECS_DEF   10U
+#define AQ_CFG_TX_DOORBELL_FRAMES_MAX  256U
+#define AQ_CFG_TX_DOORBELL_USECS_MAX   1000U
+
+/* NAPI budget per poll, napi_weight module parameter */
 #define AQ_CFG_NAPI_WEIGHT     64U
+#define AQ_CFG_NAPI_WEIGHT_MAX 256U
+
+/* RX pages dropped by XDP kept per ring for the next refill, at most one
+ * poll's worth
+ */
+#define AQ_CFG_RX_PAGE_CACHE AQ_CFG_NAPI_WEIGHT_MAX
+
+/* Run each vector's NAPI poll in its own kthread (ethtool priv flag) */
+#define AQ_CFG_IS_NAPI_THREADED_DEF 0U
+
+/* TX packets reclaimed per poll, not charged to the NAPI (RX) budget */
+#define AQ_CFG_TX_CLEAN_BUDGET 256U
 
 #define AQ_CFG_MULTICAST_ADDRESS_MAX     32U
 
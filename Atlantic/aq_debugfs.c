@@ -0,0 +1,90 @@
+/*
+ * aQuantia Corporation Network Driver
+ * Copyright (C) 2014-2017 aQuantia Corporation. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ */
+
+/* File aq_debugfs.c: Definition of debugfs entries.
+ * <debugfs>/aquantia/<pci device>/numa: per queue NUMA placement.
+ * <debugfs>/aquantia/<pci device>/moderation: per vector moderation class.
+ * <debugfs>/aquantia/<pci device>/poll: per ring RX budget share.
+ */
+
+#include "aq_debugfs.h"
+#include "aq_nic.h"
+
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+#include <linux/rtnetlink.h>
+
+static struct dentry *aq_debugfs_root;
+
+/* Every file shows one aq_nic_*_show() under rtnl */
+#define AQ_DEBUGFS_FILE(_NAME_) \
+static int aq_debugfs_##_NAME_##_show(struct seq_file *seq, void *v) \
+{ \
+	rtnl_lock(); \
+	aq_nic_##_NAME_##_show(seq->private, seq); \
+	rtnl_unlock(); \
+	return 0; \
+} \
+static int aq_debugfs_##_NAME_##_open(struct inode *inode, struct file *file) \
+{ \
+	return single_open(file, aq_debugfs_##_NAME_##_show, \
+			   inode->i_private); \
+} \
+static const struct file_operations aq_debugfs_##_NAME_##_fops = { \
+	.owner = THIS_MODULE, \
+	.open = aq_debugfs_##_NAME_##_open, \
+	.read = seq_read, \
+	.llseek = seq_lseek, \
+	.release = single_release, \
+}
+
+AQ_DEBUGFS_FILE(numa);
+AQ_DEBUGFS_FILE(moderation);
+AQ_DEBUGFS_FILE(poll);
+
+void aq_debugfs_init(void)
+{
+	aq_debugfs_root = debugfs_create_dir(AQ_CFG_DRV_NAME, NULL);
+	if (IS_ERR(aq_debugfs_root))
+		aq_debugfs_root = NULL;
+}
+
+void aq_debugfs_exit(void)
+{
+	debugfs_remove_recursive(aq_debugfs_root);
+	aq_debugfs_root = NULL;
+}
+
+struct dentry *aq_debugfs_nic_init(struct aq_nic_s *aq_nic)
+{
+	struct dentry *dir = NULL;
+
+	if (!aq_debugfs_root)
+		goto err_exit;
+
+	dir = debugfs_create_dir(dev_name(aq_nic_get_dev(aq_nic)),
+				 aq_debugfs_root);
+	if (IS_ERR_OR_NULL(dir)) {
+		dir = NULL;
+		goto err_exit;
+	}
+
+	debugfs_create_file("numa", 0400, dir, aq_nic, &aq_debugfs_numa_fops);
+	debugfs_create_file("moderation", 0400, dir, aq_nic,
+			    &aq_debugfs_moderation_fops);
+	debugfs_create_file("poll", 0400, dir, aq_nic, &aq_debugfs_poll_fops);
+
+err_exit:
+	return dir;
+}
+
+void aq_debugfs_nic_exit(struct dentry *dir)
+{
+	debugfs_remove_recursive(dir);
+}
@@ -0,0 +1,24 @@
+/*
+ * aQuantia Corporation Network Driver
+ * Copyright (C) 2014-2017 aQuantia Corporation. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ */
+
+/* File aq_debugfs.h: Declaration of debugfs entries. */
+
+#ifndef AQ_DEBUGFS_H
+#define AQ_DEBUGFS_H
+
+#include "aq_common.h"
+
+struct dentry;
+
+void aq_debugfs_init(void);
+void aq_debugfs_exit(void);
+struct dentry *aq_debugfs_nic_init(struct aq_nic_s *aq_nic);
+void aq_debugfs_nic_exit(struct dentry *dir);
+
+#endif /* AQ_DEBUGFS_H */
@@ -0,0 +1,235 @@
+/*
+ * aQuantia Corporation Network Driver
+ * Copyright (C) 2014-2017 aQuantia Corporation. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ */
+
+/* File aq_dim.c: Definition of dynamic interrupt moderation. Per vector,
+ * every AQ_CFG_DIM_EVENTS interrupts the traffic rates are compared with
+ * the previous window and the moderation profile steps towards the one
+ * giving more throughput with fewer interrupts (the net_dim algorithm).
+ */
+
+#include "aq_dim.h"
+#include "aq_cfg.h"
+
+#include <linux/kernel.h>
+
+enum {
+	AQ_DIM_PARKING_ON_TOP,
+	AQ_DIM_PARKING_TIRED,
+	AQ_DIM_GOING_RIGHT,
+	AQ_DIM_GOING_LEFT,
+};
+
+enum {
+	AQ_DIM_STATS_WORSE,
+	AQ_DIM_STATS_SAME,
+	AQ_DIM_STATS_BETTER,
+};
+
+enum {
+	AQ_DIM_STEPPED,
+	AQ_DIM_TOO_TIRED,
+	AQ_DIM_ON_EDGE,
+};
+
+/* Moderation time per profile, left is lowest latency */
+static const unsigned int aq_dim_profiles_usecs[] = { 2U, 8U, 32U, 64U, 128U };
+
+#define AQ_DIM_PROFILES ARRAY_SIZE(aq_dim_profiles_usecs)
+#define AQ_DIM_PROFILE_DEF 1U
+
+/* More than 10% apart */
+#define AQ_DIM_IS_SIGNIFICANT_DIFF(_V_, _REF_) \
+	((100UL * abs((int)(_V_) - (int)(_REF_)) / (_REF_)) > 10UL)
+
+void aq_dim_init(struct aq_dim_s *self)
+{
+	memset(self, 0, sizeof(*self));
+	self->tune_state = AQ_DIM_GOING_RIGHT;
+	self->profile_ix = AQ_DIM_PROFILE_DEF;
+}
+
+unsigned int aq_dim_usecs(struct aq_dim_s *self)
+{
+	return aq_dim_profiles_usecs[self->profile_ix];
+}
+
+static int aq_dim_rates_compare(struct aq_dim_rates_s *curr,
+				struct aq_dim_rates_s *prev)
+{
+	if (!prev->bpms)
+		return curr->bpms ? AQ_DIM_STATS_BETTER : AQ_DIM_STATS_SAME;
+
+	if (AQ_DIM_IS_SIGNIFICANT_DIFF(curr->bpms, prev->bpms))
+		return (curr->bpms > prev->bpms) ? AQ_DIM_STATS_BETTER :
+						   AQ_DIM_STATS_WORSE;
+
+	if (!prev->ppms)
+		return curr->ppms ? AQ_DIM_STATS_BETTER : AQ_DIM_STATS_SAME;
+
+	if (AQ_DIM_IS_SIGNIFICANT_DIFF(curr->ppms, prev->ppms))
+		return (curr->ppms > prev->ppms) ? AQ_DIM_STATS_BETTER :
+						   AQ_DIM_STATS_WORSE;
+
+	if (!prev->epms)
+		return AQ_DIM_STATS_SAME;
+
+	if (AQ_DIM_IS_SIGNIFICANT_DIFF(curr->epms, prev->epms))
+		return (curr->epms < prev->epms) ? AQ_DIM_STATS_BETTER :
+						   AQ_DIM_STATS_WORSE;
+
+	return AQ_DIM_STATS_SAME;
+}
+
+static int aq_dim_step(struct aq_dim_s *self)
+{
+	if (self->tired == AQ_DIM_PROFILES * 2U)
+		return AQ_DIM_TOO_TIRED;
+
+	switch (self->tune_state) {
+	case AQ_DIM_GOING_RIGHT:
+		if (self->profile_ix == AQ_DIM_PROFILES - 1U)
+			return AQ_DIM_ON_EDGE;
+		++self->profile_ix;
+		++self->steps_right;
+		break;
+
+	case AQ_DIM_GOING_LEFT:
+		if (!self->profile_ix)
+			return AQ_DIM_ON_EDGE;
+		--self->profile_ix;
+		++self->steps_left;
+		break;
+
+	default:
+		break;
+	}
+
+	++self->tired;
+	return AQ_DIM_STEPPED;
+}
+
+static bool aq_dim_on_top(struct aq_dim_s *self)
+{
+	switch (self->tune_state) {
+	case AQ_DIM_GOING_RIGHT:
+		return self->steps_left > 1U && self->steps_right == 1U;
+
+	case AQ_DIM_GOING_LEFT:
+		return self->steps_right > 1U && self->steps_left == 1U;
+
+	default:
+		return true;
+	}
+}
+
+static void aq_dim_turn(struct aq_dim_s *self)
+{
+	if (self->tune_state == AQ_DIM_GOING_RIGHT) {
+		self->tune_state = AQ_DIM_GOING_LEFT;
+		self->steps_left = 0U;
+	} else if (self->tune_state == AQ_DIM_GOING_LEFT) {
+		self->tune_state = AQ_DIM_GOING_RIGHT;
+		self->steps_right = 0U;
+	}
+}
+
+static void aq_dim_park(struct aq_dim_s *self, u8 tune_state)
+{
+	self->steps_right = 0U;
+	self->steps_left = 0U;
+	if (tune_state == AQ_DIM_PARKING_ON_TOP)
+		self->tired = 0U;
+	self->tune_state = tune_state;
+}
+
+static void aq_dim_exit_parking(struct aq_dim_s *self)
+{
+	self->tune_state = self->profile_ix ? AQ_DIM_GOING_LEFT :
+					      AQ_DIM_GOING_RIGHT;
+	aq_dim_step(self);
+}
+
+static bool aq_dim_decide(struct aq_dim_s *self, struct aq_dim_rates_s *curr)
+{
+	u8 prev_state = self->tune_state;
+	u8 prev_ix = self->profile_ix;
+
+	switch (self->tune_state) {
+	case AQ_DIM_PARKING_ON_TOP:
+		if (aq_dim_rates_compare(curr, &self->prev) !=
+		    AQ_DIM_STATS_SAME)
+			aq_dim_exit_parking(self);
+		break;
+
+	case AQ_DIM_PARKING_TIRED:
+		if (!--self->tired)
+			aq_dim_exit_parking(self);
+		break;
+
+	default:
+		if (aq_dim_rates_compare(curr, &self->prev) !=
+		    AQ_DIM_STATS_BETTER)
+			aq_dim_turn(self);
+
+		if (aq_dim_on_top(self)) {
+			aq_dim_park(self, AQ_DIM_PARKING_ON_TOP);
+			break;
+		}
+
+		switch (aq_dim_step(self)) {
+		case AQ_DIM_ON_EDGE:
+			aq_dim_park(self, AQ_DIM_PARKING_ON_TOP);
+			break;
+
+		case AQ_DIM_TOO_TIRED:
+			aq_dim_park(self, AQ_DIM_PARKING_TIRED);
+			break;
+		}
+		break;
+	}
+
+	if (prev_state != AQ_DIM_PARKING_ON_TOP ||
+	    self->tune_state != AQ_DIM_PARKING_ON_TOP)
+		self->prev = *curr;
+
+	return self->profile_ix != prev_ix;
+}
+
+/* Returns true when the profile changed and has to be programmed */
+bool aq_dim_update(struct aq_dim_s *self, struct aq_dim_sample_s *sample)
+{
+	struct aq_dim_rates_s curr;
+	bool is_changed = false;
+	u32 delta_us = 0U;
+
+	if (!self->is_measuring)
+		goto err_restart;
+
+	if (sample->events - self->start.events < AQ_CFG_DIM_EVENTS)
+		goto err_exit;
+
+	delta_us = ktime_us_delta(sample->time, self->start.time);
+	if (!delta_us)
+		goto err_restart;
+
+	curr.ppms = DIV_ROUND_UP_ULL((sample->packets - self->start.packets) *
+				     USEC_PER_MSEC, delta_us);
+	curr.bpms = DIV_ROUND_UP_ULL((sample->bytes - self->start.bytes) *
+				     USEC_PER_MSEC, delta_us);
+	curr.epms = DIV_ROUND_UP(AQ_CFG_DIM_EVENTS * USEC_PER_MSEC, delta_us);
+
+	is_changed = aq_dim_decide(self, &curr);
+
+err_restart:
+	self->start = *sample;
+	self->is_measuring = true;
+
+err_exit:
+	return is_changed;
+}
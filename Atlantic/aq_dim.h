@@ -0,0 +1,47 @@
+/*
+ * aQuantia Corporation Network Driver
+ * Copyright (C) 2014-2017 aQuantia Corporation. All rights reserved
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ */
+
+/* File aq_dim.h: Declaration of dynamic interrupt moderation. */
+
+#ifndef AQ_DIM_H
+#define AQ_DIM_H
+
+#include "aq_common.h"
+
+#include <linux/ktime.h>
+
+struct aq_dim_sample_s {
+	ktime_t time;
+	u64 packets;
+	u64 bytes;
+	u32 events;
+};
+
+struct aq_dim_rates_s {
+	u32 ppms;	/* packets per msec */
+	u32 bpms;	/* bytes per msec */
+	u32 epms;	/* interrupts per msec */
+};
+
+struct aq_dim_s {
+	struct aq_dim_sample_s start;
+	struct aq_dim_rates_s prev;
+	bool is_measuring;
+	u8 tune_state;
+	u8 profile_ix;
+	u8 steps_right;
+	u8 steps_left;
+	u8 tired;
+};
+
+void aq_dim_init(struct aq_dim_s *self);
+bool aq_dim_update(struct aq_dim_s *self, struct aq_dim_sample_s *sample);
+unsigned int aq_dim_usecs(struct aq_dim_s *self);
+
+#endif /* AQ_DIM_H */
@@ -55,10 +55,6 @@ static int aq_ethtool_set_settings(struct net_device *ndev,
 	return aq_nic_set_link_settings(aq_nic, cmd);
 }
 
-/* there "5U" is number of queue[#] stats lines (InPackets+...+InErrors) */
-static const unsigned int aq_ethtool_stat_queue_lines = 5U;
-static const unsigned int aq_ethtool_stat_queue_chars =
-	5U * ETH_GSTRING_LEN;
 static const char aq_ethtool_stat_names[][ETH_GSTRING_LEN] = {
 	"InPackets",
 	"InUCast",
@@ -82,56 +78,43 @@ static const char aq_ethtool_stat_names[][ETH_GSTRING_LEN] = {
 	"InOctetsDma",
 	"OutOctetsDma",
 	"InDroppedDma",
-	"Queue[0] InPackets",
-	"Queue[0] OutPackets",
-	"Queue[0] InJumboPackets",
-	"Queue[0] InLroPackets",
-	"Queue[0] InErrors",
-	"Queue[1] InPackets",
-	"Queue[1] OutPackets",
-	"Queue[1] InJumboPackets",
-	"Queue[1] InLroPackets",
-	"Queue[1] InErrors",
-	"Queue[2] InPackets",
-	"Queue[2] OutPackets",
-	"Queue[2] InJumboPackets",
-	"Queue[2] InLroPackets",
-	"Queue[2] InErrors",
-	"Queue[3] InPackets",
-	"Queue[3] OutPackets",
-	"Queue[3] InJumboPackets",
-	"Queue[3] InLroPackets",
-	"Queue[3] InErrors",
-	"Queue[4] InPackets",
-	"Queue[4] OutPackets",
-	"Queue[4] InJumboPackets",
-	"Queue[4] InLroPackets",
-	"Queue[4] InErrors",
-	"Queue[5] InPackets",
-	"Queue[5] OutPackets",
-	"Queue[5] InJumboPackets",
-	"Queue[5] InLroPackets",
-	"Queue[5] InErrors",
-	"Queue[6] InPackets",
-	"Queue[6] OutPackets",
-	"Queue[6] InJumboPackets",
-	"Queue[6] InLroPackets",
-	"Queue[6] InErrors",
-	"Queue[7] InPackets",
-	"Queue[7] OutPackets",
-	"Queue[7] InJumboPackets",
-	"Queue[7] InLroPackets",
-	"Queue[7] InErrors",
+};
+
+/* Per queue stats, "%u" is replaced by the queue index */
+static const char aq_ethtool_queue_stat_names[][ETH_GSTRING_LEN] = {
+	"Queue[%u] InPackets",
+	"Queue[%u] OutPackets",
+	"Queue[%u] InJumboPackets",
+	"Queue[%u] InLroPackets",
+	"Queue[%u] InErrors",
+	"Queue[%u] OutStopsAvoided",
+	"Queue[%u] OutCrossCpu",
+	"Queue[%u] PollContended",
+	"Queue[%u] Polls",
+	"Queue[%u] PollMmioReads",
+	"Queue[%u] InPollStarved",
+};
+
+static unsigned int aq_ethtool_n_stats(struct aq_nic_cfg_s *cfg)
+{
+	return ARRAY_SIZE(aq_ethtool_stat_names) +
+		cfg->vecs * ARRAY_SIZE(aq_ethtool_queue_stat_names);
+}
+
+static const char aq_ethtool_priv_flag_names[][ETH_GSTRING_LEN] = {
+	"tx-flow-affine",
+	"tx-irq-separate",
+	"napi-threaded",
+	"polling",
 };
 
 static void aq_ethtool_stats(struct net_device *ndev,
 			     struct ethtool_stats *stats, u64 *data)
 {
 	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
 
-/* ASSERT: Need add lines to aq_ethtool_stat_names if AQ_CFG_VECS_MAX > 8 */
-	BUILD_BUG_ON(AQ_CFG_VECS_MAX > 8);
-	memset(data, 0, ARRAY_SIZE(aq_ethtool_stat_names) * sizeof(u64));
+	memset(data, 0, aq_ethtool_n_stats(cfg) * sizeof(u64));
 	aq_nic_get_stats(aq_nic, data);
 }
 
@@ -153,8 +136,8 @@ static void aq_ethtool_get_drvinfo(struct net_device *ndev,
 
 	strlcpy(drvinfo->bus_info, pdev ? pci_name(pdev) : "",
 		sizeof(drvinfo->bus_info));
-	drvinfo->n_stats = ARRAY_SIZE(aq_ethtool_stat_names) -
-		(AQ_CFG_VECS_MAX - cfg->vecs) * aq_ethtool_stat_queue_lines;
+	drvinfo->n_stats = aq_ethtool_n_stats(cfg);
+	drvinfo->n_priv_flags = ARRAY_SIZE(aq_ethtool_priv_flag_names);
 	drvinfo->testinfo_len = 0;
 	drvinfo->regdump_len = regs_count;
 	drvinfo->eedump_len = 0;
@@ -165,12 +148,31 @@ static void aq_ethtool_get_strings(struct net_device *ndev,
 {
 	struct aq_nic_s *aq_nic = netdev_priv(ndev);
 	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
+	unsigned int i = 0U;
+	unsigned int si = 0U;
 
-	if (stringset == ETH_SS_STATS)
+	switch (stringset) {
+	case ETH_SS_STATS:
 		memcpy(data, *aq_ethtool_stat_names,
-		       sizeof(aq_ethtool_stat_names) -
-		       (AQ_CFG_VECS_MAX - cfg->vecs) *
-		       aq_ethtool_stat_queue_chars);
+		       sizeof(aq_ethtool_stat_names));
+		data += sizeof(aq_ethtool_stat_names);
+
+		for (i = 0U; i < cfg->vecs; i++) {
+			for (si = 0U;
+			     si < ARRAY_SIZE(aq_ethtool_queue_stat_names);
+			     si++) {
+				snprintf((char *)data, ETH_GSTRING_LEN,
+					 aq_ethtool_queue_stat_names[si], i);
+				data += ETH_GSTRING_LEN;
+			}
+		}
+		break;
+
+	case ETH_SS_PRIV_FLAGS:
+		memcpy(data, *aq_ethtool_priv_flag_names,
+		       sizeof(aq_ethtool_priv_flag_names));
+		break;
+	}
 }
 
 static int aq_ethtool_get_sset_count(struct net_device *ndev, int stringset)
@@ -181,9 +183,10 @@ static int aq_ethtool_get_sset_count(struct net_device *ndev, int stringset)
 
 	switch (stringset) {
 	case ETH_SS_STATS:
-		ret = ARRAY_SIZE(aq_ethtool_stat_names) -
-			(AQ_CFG_VECS_MAX - cfg->vecs) *
-			aq_ethtool_stat_queue_lines;
+		ret = aq_ethtool_n_stats(cfg);
+		break;
+	case ETH_SS_PRIV_FLAGS:
+		ret = ARRAY_SIZE(aq_ethtool_priv_flag_names);
 		break;
 	default:
 		ret = -EOPNOTSUPP;
@@ -244,6 +247,241 @@ static int aq_ethtool_get_rxnfc(struct net_device *ndev,
 	return err;
 }
 
+static void aq_ethtool_get_channels(struct net_device *ndev,
+				    struct ethtool_channels *ch)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
+
+	ch->max_combined = aq_nic_get_vecs_max(aq_nic);
+	ch->combined_count = cfg->vecs;
+}
+
+/* Each vector serves one RX and one TX queue */
+static int aq_ethtool_set_channels(struct net_device *ndev,
+				   struct ethtool_channels *ch)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	int err = 0;
+
+	if (ch->rx_count || ch->tx_count || ch->other_count) {
+		err = -EINVAL;
+		goto err_exit;
+	}
+
+	err = aq_nic_set_vecs(aq_nic, ch->combined_count);
+
+err_exit:
+	return err;
+}
+
+/* Moderation is time based only, the hardware has no frame thresholds.
+ * AQ_CFG_ITR_AUTO selects the timers by link speed.
+ */
+static int aq_ethtool_check_itr(struct ethtool_coalesce *coal)
+{
+	if (coal->rx_max_coalesced_frames || coal->tx_max_coalesced_frames)
+		return -EOPNOTSUPP;
+
+	if ((coal->rx_coalesce_usecs > AQ_CFG_ITR_USECS_MAX &&
+	     coal->rx_coalesce_usecs != AQ_CFG_ITR_AUTO) ||
+	    (coal->tx_coalesce_usecs > AQ_CFG_ITR_USECS_MAX &&
+	     coal->tx_coalesce_usecs != AQ_CFG_ITR_AUTO))
+		return -EINVAL;
+
+	return 0;
+}
+
+static int aq_ethtool_get_coalesce(struct net_device *ndev,
+				   struct ethtool_coalesce *coal)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
+
+	/* Queue 0 stands for the device, see the per queue variants */
+	coal->rx_coalesce_usecs = cfg->rx_itr[0];
+	coal->tx_coalesce_usecs = cfg->tx_itr[0];
+
+	coal->use_adaptive_rx_coalesce = !!(cfg->rx_dim_mask & BIT(0));
+	coal->use_adaptive_tx_coalesce = !!(cfg->tx_dim_mask & BIT(0));
+
+	return 0;
+}
+
+static int aq_ethtool_set_coalesce(struct net_device *ndev,
+				   struct ethtool_coalesce *coal)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
+	bool is_rx_itr_changed = false;
+	bool is_tx_itr_changed = false;
+	bool is_itr_changed = false;
+	unsigned int i = 0U;
+	int err = 0;
+
+	err = aq_ethtool_check_itr(coal);
+	if (err < 0)
+		goto err_exit;
+
+	/* Untouched values keep the per queue settings */
+	is_rx_itr_changed = coal->rx_coalesce_usecs != cfg->rx_itr[0];
+	is_tx_itr_changed = coal->tx_coalesce_usecs != cfg->tx_itr[0];
+
+	for (i = 0U; i < AQ_CFG_VECS_MAX; ++i) {
+		if (is_rx_itr_changed)
+			cfg->rx_itr[i] = coal->rx_coalesce_usecs;
+		if (is_tx_itr_changed)
+			cfg->tx_itr[i] = coal->tx_coalesce_usecs;
+	}
+	is_itr_changed = is_rx_itr_changed || is_tx_itr_changed;
+
+	if (!!(cfg->rx_dim_mask & BIT(0)) != !!coal->use_adaptive_rx_coalesce) {
+		cfg->rx_dim_mask = coal->use_adaptive_rx_coalesce ?
+			GENMASK(AQ_CFG_VECS_MAX - 1U, 0U) : 0U;
+		is_itr_changed = true;
+	}
+	if (!!(cfg->tx_dim_mask & BIT(0)) != !!coal->use_adaptive_tx_coalesce) {
+		cfg->tx_dim_mask = coal->use_adaptive_tx_coalesce ?
+			GENMASK(AQ_CFG_VECS_MAX - 1U, 0U) : 0U;
+		is_itr_changed = true;
+	}
+
+	/* Otherwise picked up on the next start */
+	if (is_itr_changed && netif_running(ndev))
+		aq_nic_update_interrupt_moderation(aq_nic);
+
+err_exit:
+	return err;
+}
+
+static int aq_ethtool_get_per_queue_coalesce(struct net_device *ndev,
+					     u32 queue,
+					     struct ethtool_coalesce *coal)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
+	int err = 0;
+
+	if (queue >= cfg->vecs) {
+		err = -EINVAL;
+		goto err_exit;
+	}
+
+	err = aq_ethtool_get_coalesce(ndev, coal);
+	if (err < 0)
+		goto err_exit;
+
+	coal->rx_coalesce_usecs = cfg->rx_itr[queue];
+	coal->tx_coalesce_usecs = cfg->tx_itr[queue];
+	coal->use_adaptive_rx_coalesce = !!(cfg->rx_dim_mask & BIT(queue));
+	coal->use_adaptive_tx_coalesce = !!(cfg->tx_dim_mask & BIT(queue));
+
+err_exit:
+	return err;
+}
+
+/* Only the moderation class of the queue is per queue: adaptive, fixed
+ * usecs (0 for a latency queue) or by link speed. The rest is device wide.
+ */
+static int aq_ethtool_set_per_queue_coalesce(struct net_device *ndev,
+					     u32 queue,
+					     struct ethtool_coalesce *coal)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
+	int err = 0;
+
+	if (queue >= cfg->vecs) {
+		err = -EINVAL;
+		goto err_exit;
+	}
+
+	err = aq_ethtool_check_itr(coal);
+	if (err < 0)
+		goto err_exit;
+
+	cfg->rx_itr[queue] = coal->rx_coalesce_usecs;
+	cfg->tx_itr[queue] = coal->tx_coalesce_usecs;
+
+	if (coal->use_adaptive_rx_coalesce)
+		cfg->rx_dim_mask |= BIT(queue);
+	else
+		cfg->rx_dim_mask &= ~BIT(queue);
+
+	if (coal->use_adaptive_tx_coalesce)
+		cfg->tx_dim_mask |= BIT(queue);
+	else
+		cfg->tx_dim_mask &= ~BIT(queue);
+
+	if (netif_running(ndev))
+		aq_nic_update_interrupt_moderation(aq_nic);
+
+err_exit:
+	return err;
+}
+
+static u32 aq_ethtool_get_priv_flags(struct net_device *ndev)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
+	u32 priv_flags = 0U;
+
+	if (cfg->is_tx_flow_affine)
+		priv_flags |= AQ_NIC_PRIV_FLAG_TX_FLOW_AFFINE;
+	if (cfg->is_tx_irq_separate)
+		priv_flags |= AQ_NIC_PRIV_FLAG_TX_IRQ_SEPARATE;
+	if (cfg->is_napi_threaded)
+		priv_flags |= AQ_NIC_PRIV_FLAG_NAPI_THREADED;
+	if (cfg->is_polling)
+		priv_flags |= AQ_NIC_PRIV_FLAG_POLLING;
+
+	return priv_flags;
+}
+
+static int aq_ethtool_set_priv_flags(struct net_device *ndev, u32 priv_flags)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(aq_nic);
+	bool is_tx_irq_separate =
+		!!(priv_flags & AQ_NIC_PRIV_FLAG_TX_IRQ_SEPARATE);
+	bool is_napi_threaded =
+		!!(priv_flags & AQ_NIC_PRIV_FLAG_NAPI_THREADED);
+	bool is_polling = !!(priv_flags & AQ_NIC_PRIV_FLAG_POLLING);
+	int err = 0;
+
+	cfg->is_tx_flow_affine =
+		!!(priv_flags & AQ_NIC_PRIV_FLAG_TX_FLOW_AFFINE);
+
+	/* The remaining flags take effect on the next interface start */
+	if (is_tx_irq_separate == cfg->is_tx_irq_separate &&
+	    is_napi_threaded == cfg->is_napi_threaded &&
+	    is_polling == cfg->is_polling)
+		goto err_exit;
+
+	if (netif_running(ndev))
+		ndev->netdev_ops->ndo_stop(ndev);
+
+	cfg->is_napi_threaded = is_napi_threaded;
+	cfg->is_polling = is_polling;
+	cfg->is_tx_irq_separate = is_tx_irq_separate;
+	err = aq_nic_cfg_start(aq_nic);
+	if (err < 0)
+		goto err_exit;
+
+	if (is_tx_irq_separate && !cfg->is_tx_irq_separate)
+		err = -EOPNOTSUPP;
+
+	if (netif_running(ndev)) {
+		int err_open = ndev->netdev_ops->ndo_open(ndev);
+
+		if (err_open < 0)
+			err = err_open;
+	}
+
+err_exit:
+	return err;
+}
+
 const struct ethtool_ops aq_ethtool_ops = {
 	.get_link            = aq_ethtool_get_link,
 	.get_regs_len        = aq_ethtool_get_regs_len,
@@ -256,6 +494,14 @@ const struct ethtool_ops aq_ethtool_ops = {
 	.get_rxfh_key_size   = aq_ethtool_get_rss_key_size,
 	.get_rxfh            = aq_ethtool_get_rss,
 	.get_rxnfc           = aq_ethtool_get_rxnfc,
+	.get_channels        = aq_ethtool_get_channels,
+	.set_channels        = aq_ethtool_set_channels,
+	.get_coalesce        = aq_ethtool_get_coalesce,
+	.set_coalesce        = aq_ethtool_set_coalesce,
+	.get_per_queue_coalesce = aq_ethtool_get_per_queue_coalesce,
+	.set_per_queue_coalesce = aq_ethtool_set_per_queue_coalesce,
+	.get_priv_flags      = aq_ethtool_get_priv_flags,
+	.set_priv_flags      = aq_ethtool_set_priv_flags,
 	.get_sset_count      = aq_ethtool_get_sset_count,
 	.get_ethtool_stats   = aq_ethtool_stats
 };
@@ -26,6 +26,8 @@ struct aq_hw_caps_s {
 	u32 txhwb_alignment;
 	u32 irq_mask;
 	u32 vecs;
+	u32 rss_max;
+	u32 rss_redirection_max;
 	u32 mtu;
 	u32 mac_regs_count;
 	u8 ports;
@@ -90,6 +92,9 @@ struct aq_hw_ops {
 	int (*hw_ring_tx_xmit)(struct aq_hw_s *self, struct aq_ring_s *aq_ring,
 			       unsigned int frags);
 
+	int (*hw_ring_tx_tail_update)(struct aq_hw_s *self,
+				      struct aq_ring_s *aq_ring);
+
 	int (*hw_ring_rx_receive)(struct aq_hw_s *self,
 				  struct aq_ring_s *aq_ring);
 
@@ -122,6 +127,8 @@ struct aq_hw_ops {
 	int (*hw_ring_tx_init)(struct aq_hw_s *self, struct aq_ring_s *aq_ring,
 			       struct aq_ring_param_s *aq_ring_param);
 
+	int (*hw_ring_cpu_set)(struct aq_hw_s *self, struct aq_ring_s *aq_ring);
+
 	int (*hw_ring_tx_start)(struct aq_hw_s *self,
 				struct aq_ring_s *aq_ring);
 
@@ -155,6 +162,14 @@ struct aq_hw_ops {
 	int (*hw_interrupt_moderation_set)(struct aq_hw_s *self,
 					   bool itr_enabled);
 
+	int (*hw_ring_rx_moderation_set)(struct aq_hw_s *self,
+					 struct aq_ring_s *aq_ring,
+					 unsigned int usecs);
+
+	int (*hw_ring_tx_moderation_set)(struct aq_hw_s *self,
+					 struct aq_ring_s *aq_ring,
+					 unsigned int usecs);
+
 	int (*hw_rss_set)(struct aq_hw_s *self,
 			  struct aq_rss_parameters *rss_params);
 
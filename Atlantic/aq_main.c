@@ -13,10 +13,13 @@
 #include "aq_nic.h"
 #include "aq_pci_func.h"
 #include "aq_ethtool.h"
+#include "aq_debugfs.h"
 #include "hw_atl/hw_atl_a0.h"
 #include "hw_atl/hw_atl_b0.h"
 
 #include <linux/netdevice.h>
+#include <linux/if_vlan.h>
+#include <linux/filter.h>
 #include <linux/module.h>
 
 static const struct pci_device_id aq_pci_tbl[] = {
@@ -97,6 +100,15 @@ err_exit:
 	return err;
 }
 
+static u16 aq_ndev_select_queue(struct net_device *ndev, struct sk_buff *skb,
+				void *accel_priv,
+				select_queue_fallback_t fallback)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+
+	return aq_nic_select_queue(aq_nic, skb, fallback);
+}
+
 static int aq_ndev_change_mtu(struct net_device *ndev, int new_mtu)
 {
 	struct aq_nic_s *aq_nic = netdev_priv(ndev);
@@ -110,6 +122,12 @@ static int aq_ndev_change_mtu(struct net_device *ndev, int new_mtu)
 		err = -EINVAL;
 		goto err_exit;
 	}
+	/* XDP needs the frame in a single RX buffer */
+	if (aq_nic_get_xdp_prog(aq_nic) &&
+	    new_mtu + ETH_HLEN + VLAN_HLEN > AQ_CFG_RX_FRAME_MAX) {
+		err = -EINVAL;
+		goto err_exit;
+	}
 	err = aq_nic_set_mtu(aq_nic, new_mtu + ETH_HLEN);
 	if (err < 0)
 		goto err_exit;
@@ -124,6 +142,18 @@ err_exit:
 	return err;
 }
 
+static netdev_features_t aq_ndev_fix_features(struct net_device *ndev,
+					      netdev_features_t features)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+
+	/* XDP sees single buffer frames only */
+	if (aq_nic_get_xdp_prog(aq_nic))
+		features &= ~NETIF_F_LRO;
+
+	return features;
+}
+
 static int aq_ndev_set_features(struct net_device *ndev,
 				netdev_features_t features)
 {
@@ -181,14 +211,57 @@ static void aq_ndev_set_multicast_settings(struct net_device *ndev)
 err_exit:;
 }
 
+static int aq_ndev_xdp(struct net_device *ndev, struct netdev_xdp *xdp)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+	struct bpf_prog *prog = NULL;
+	int err = 0;
+
+	switch (xdp->command) {
+	case XDP_SETUP_PROG:
+		err = aq_nic_xdp_setup(aq_nic, xdp->prog, xdp->extack);
+		break;
+	case XDP_QUERY_PROG:
+		prog = aq_nic_get_xdp_prog(aq_nic);
+		xdp->prog_attached = !!prog;
+		xdp->prog_id = prog ? prog->aux->id : 0U;
+		break;
+	default:
+		err = -EINVAL;
+		break;
+	}
+
+	return err;
+}
+
+/* Target of XDP_REDIRECT from other devices, needs an XDP program here */
+static int aq_ndev_xdp_xmit(struct net_device *ndev, struct xdp_buff *xdp)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+
+	return aq_nic_xdp_redirect_xmit(aq_nic, xdp);
+}
+
+static void aq_ndev_xdp_flush(struct net_device *ndev)
+{
+	struct aq_nic_s *aq_nic = netdev_priv(ndev);
+
+	aq_nic_xdp_redirect_flush(aq_nic);
+}
+
 static const struct net_device_ops aq_ndev_ops = {
 	.ndo_open = aq_ndev_open,
 	.ndo_stop = aq_ndev_close,
 	.ndo_start_xmit = aq_ndev_start_xmit,
+	.ndo_select_queue = aq_ndev_select_queue,
 	.ndo_set_rx_mode = aq_ndev_set_multicast_settings,
 	.ndo_change_mtu = aq_ndev_change_mtu,
 	.ndo_set_mac_address = aq_ndev_set_mac_address,
-	.ndo_set_features = aq_ndev_set_features
+	.ndo_fix_features = aq_ndev_fix_features,
+	.ndo_set_features = aq_ndev_set_features,
+	.ndo_xdp = aq_ndev_xdp,
+	.ndo_xdp_xmit = aq_ndev_xdp_xmit,
+	.ndo_xdp_flush = aq_ndev_xdp_flush
 };
 
 static int aq_pci_probe(struct pci_dev *pdev,
@@ -256,10 +329,19 @@ static int __init aq_module_init(void)
 {
 	int err = 0;
 
-	err = pci_register_driver(&aq_pci_ops);
+	err = aq_nic_cpuhp_init();
 	if (err < 0)
 		goto err_exit;
 
+	aq_debugfs_init();
+
+	err = pci_register_driver(&aq_pci_ops);
+	if (err < 0) {
+		aq_debugfs_exit();
+		aq_nic_cpuhp_exit();
+		goto err_exit;
+	}
+
 err_exit:
 	return err;
 }
@@ -267,6 +349,8 @@ err_exit:
 static void __exit aq_module_exit(void)
 {
 	pci_unregister_driver(&aq_pci_ops);
+	aq_debugfs_exit();
+	aq_nic_cpuhp_exit();
 }
 
 module_init(aq_module_init);
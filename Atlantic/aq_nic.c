@@ -14,15 +14,43 @@
 #include "aq_vec.h"
 #include "aq_hw.h"
 #include "aq_pci_func.h"
+#include "aq_debugfs.h"
 #include "aq_nic_internal.h"
 
+#include <linux/module.h>
 #include <linux/netdevice.h>
 #include <linux/etherdevice.h>
+#include <linux/if_vlan.h>
+#include <linux/filter.h>
 #include <linux/timer.h>
 #include <linux/cpu.h>
+#include <linux/seq_file.h>
+#include <linux/topology.h>
 #include <linux/ip.h>
 #include <linux/tcp.h>
 #include <net/ip.h>
+#include <net/sock.h>
+#include <net/flow_dissector.h>
+
+static unsigned int aq_nic_napi_weight = AQ_CFG_NAPI_WEIGHT;
+module_param_named(napi_weight, aq_nic_napi_weight, uint, 0444);
+MODULE_PARM_DESC(napi_weight, "NAPI budget per poll, 1.."
+		 __stringify(AQ_CFG_NAPI_WEIGHT_MAX));
+
+static unsigned int aq_nic_polling_usecs = AQ_CFG_POLLING_USECS_DEF;
+module_param_named(polling_usecs, aq_nic_polling_usecs, uint, 0444);
+MODULE_PARM_DESC(polling_usecs, "NAPI scheduling interval of the polling "
+		 "priv flag in usecs, 1.." __stringify(AQ_CFG_POLLING_USECS_MAX));
+
+static unsigned int aq_nic_tx_doorbell_frames = AQ_CFG_TX_DOORBELL_FRAMES_DEF;
+module_param_named(tx_doorbell_frames, aq_nic_tx_doorbell_frames, uint, 0444);
+MODULE_PARM_DESC(tx_doorbell_frames, "TX descriptors per doorbell, 0/1 off, "
+		 "up to " __stringify(AQ_CFG_TX_DOORBELL_FRAMES_MAX));
+
+static unsigned int aq_nic_tx_doorbell_usecs = AQ_CFG_TX_DOORBELL_USECS_DEF;
+module_param_named(tx_doorbell_usecs, aq_nic_tx_doorbell_usecs, uint, 0444);
+MODULE_PARM_DESC(tx_doorbell_usecs, "Max TX doorbell delay in usecs, 1.."
+		 __stringify(AQ_CFG_TX_DOORBELL_USECS_MAX));
 
 static void aq_nic_rss_init(struct aq_nic_s *self, unsigned int num_rss_queues)
 {
@@ -40,16 +68,22 @@ static void aq_nic_rss_init(struct aq_nic_s *self, unsigned int num_rss_queues)
 
 	rss_params->hash_secret_key_size = sizeof(rss_key);
 	memcpy(rss_params->hash_secret_key, rss_key, sizeof(rss_key));
-	rss_params->indirection_table_size = AQ_CFG_RSS_INDIRECTION_TABLE_MAX;
-
-	for (i = rss_params->indirection_table_size; i--;)
-		rss_params->indirection_table[i] = i & (num_rss_queues - 1);
+	rss_params->indirection_table_size =
+		min(AQ_CFG_RSS_INDIRECTION_TABLE_MAX,
+		    cfg->aq_hw_caps->rss_redirection_max);
+
+	/* Round robin, repeated every indirection_table_size entries */
+	for (i = AQ_CFG_RSS_INDIRECTION_TABLE_MAX; i--;)
+		rss_params->indirection_table[i] =
+			(i % rss_params->indirection_table_size) %
+			num_rss_queues;
 }
 
 /* Fills aq_nic_cfg with valid defaults */
 static void aq_nic_cfg_init_defaults(struct aq_nic_s *self)
 {
 	struct aq_nic_cfg_s *cfg = &self->aq_nic_cfg;
+	unsigned int i = 0U;
 
 	cfg->aq_hw_caps = &self->aq_hw_caps;
 
@@ -60,10 +94,20 @@ static void aq_nic_cfg_init_defaults(struct aq_nic_s *self)
 	cfg->txds = AQ_CFG_TXDS_DEF;
 
 	cfg->is_polling = AQ_CFG_IS_POLLING_DEF;
+	cfg->polling_usecs = clamp(aq_nic_polling_usecs, 1U,
+				   AQ_CFG_POLLING_USECS_MAX);
+	cfg->napi_weight = clamp(aq_nic_napi_weight, 1U,
+				 AQ_CFG_NAPI_WEIGHT_MAX);
 
 	cfg->is_interrupt_moderation = AQ_CFG_IS_INTERRUPT_MODERATION_DEF;
-	cfg->itr = cfg->is_interrupt_moderation ?
-		AQ_CFG_INTERRUPT_MODERATION_RATE_DEF : 0U;
+	for (i = 0U; i < AQ_CFG_VECS_MAX; ++i) {
+		cfg->rx_itr[i] = AQ_CFG_INTERRUPT_MODERATION_RATE_DEF;
+		cfg->tx_itr[i] = AQ_CFG_INTERRUPT_MODERATION_RATE_DEF;
+	}
+	cfg->rx_dim_mask = AQ_CFG_IS_RX_DIM_DEF ?
+		GENMASK(AQ_CFG_VECS_MAX - 1U, 0U) : 0U;
+	cfg->tx_dim_mask = AQ_CFG_IS_TX_DIM_DEF ?
+		GENMASK(AQ_CFG_VECS_MAX - 1U, 0U) : 0U;
 
 	cfg->is_rss = AQ_CFG_IS_RSS_DEF;
 	cfg->num_rss_queues = AQ_CFG_NUM_RSS_QUEUES_DEF;
@@ -76,85 +120,172 @@ static void aq_nic_cfg_init_defaults(struct aq_nic_s *self)
 
 	cfg->is_lro = AQ_CFG_IS_LRO_DEF;
 
+	cfg->is_tx_flow_affine = AQ_CFG_IS_TX_FLOW_AFFINE_DEF;
+	cfg->is_tx_irq_separate = AQ_CFG_IS_TX_IRQ_SEPARATE_DEF;
+	cfg->is_napi_threaded = AQ_CFG_IS_NAPI_THREADED_DEF;
+
 	cfg->vlan_id = 0U;
 
+	cfg->tx_doorbell_frames = (aq_nic_tx_doorbell_frames > 1U) ?
+		min(aq_nic_tx_doorbell_frames, AQ_CFG_TX_DOORBELL_FRAMES_MAX) :
+		0U;
+	cfg->tx_doorbell_usecs = clamp(aq_nic_tx_doorbell_usecs, 1U,
+				       AQ_CFG_TX_DOORBELL_USECS_MAX);
+
 	aq_nic_rss_init(self, cfg->num_rss_queues);
 }
 
+/* Queue count limit: hardware rings, online CPUs and MSI-X vectors */
+unsigned int aq_nic_get_vecs_max(struct aq_nic_s *self)
+{
+	struct aq_nic_cfg_s *cfg = &self->aq_nic_cfg;
+	unsigned int irq_vecs = aq_pci_func_get_irq_vecs(self->aq_pci_func);
+	unsigned int vecs = min(cfg->aq_hw_caps->vecs, num_online_cpus());
+
+	vecs = max(min(vecs, irq_vecs), 1U);
+
+	/* Rings are laid out per TC with a stride of AQ_CFG_TCS_MAX, more
+	 * vectors than that would alias the rings of the next TC.
+	 */
+	if (cfg->tcs > 1U)
+		vecs = min(vecs, AQ_CFG_TCS_MAX);
+
+	if (cfg->irq_type != AQ_HW_IRQ_MSIX || self->aq_hw_caps.vecs == 1U)
+		vecs = 1U;
+
+	return vecs;
+}
+
 /* Checks hw_caps and 'corrects' aq_nic_cfg in runtime */
 int aq_nic_cfg_start(struct aq_nic_s *self)
 {
 	struct aq_nic_cfg_s *cfg = &self->aq_nic_cfg;
+	unsigned int irq_vecs = 0U;
+	unsigned int used_vecs = 0U;
 
 	/*descriptors */
 	cfg->rxds = min(cfg->rxds, cfg->aq_hw_caps->rxds);
 	cfg->txds = min(cfg->txds, cfg->aq_hw_caps->txds);
 
-	/*rss rings */
-	cfg->vecs = min(cfg->vecs, cfg->aq_hw_caps->vecs);
-	cfg->vecs = min(cfg->vecs, num_online_cpus());
-	/* cfg->vecs should be power of 2 for RSS */
-	if (cfg->vecs >= 8U)
-		cfg->vecs = 8U;
-	else if (cfg->vecs >= 4U)
-		cfg->vecs = 4U;
-	else if (cfg->vecs >= 2U)
-		cfg->vecs = 2U;
-	else
-		cfg->vecs = 1U;
-
 	cfg->irq_type = aq_pci_func_get_irq_type(self->aq_pci_func);
+	irq_vecs = aq_pci_func_get_irq_vecs(self->aq_pci_func);
 
-	if ((cfg->irq_type == AQ_HW_IRQ_LEGACY) ||
+	/*rss rings */
+	cfg->vecs = min(cfg->vecs, aq_nic_get_vecs_max(self));
+
+	if ((cfg->irq_type != AQ_HW_IRQ_MSIX) ||
 	    (self->aq_hw_caps.vecs == 1U) ||
 	    (cfg->vecs == 1U)) {
 		cfg->is_rss = 0U;
 		cfg->vecs = 1U;
 	}
 
+	/* RSS spreads over the first rss_max queues only, the rest are
+	 * reached via XPS and queue selection.
+	 */
+	cfg->num_rss_queues = min(cfg->vecs, cfg->aq_hw_caps->rss_max);
+	aq_nic_rss_init(self, cfg->num_rss_queues);
+
+	/* TX vectors follow the ring vectors, the link vector comes last */
+	if (cfg->irq_type != AQ_HW_IRQ_MSIX || 2U * cfg->vecs > irq_vecs)
+		cfg->is_tx_irq_separate = false;
+
+	used_vecs = cfg->is_tx_irq_separate ? 2U * cfg->vecs : cfg->vecs;
+
+	/* In polling mode no IRQ is requested, the link is polled too */
+	cfg->is_link_irq = !cfg->is_polling &&
+			   (cfg->irq_type == AQ_HW_IRQ_MSIX) &&
+			   (used_vecs < irq_vecs);
+	cfg->link_irq_vec = used_vecs;
+
+	cfg->irq_mask = GENMASK(used_vecs - 1U, 0U);
+	if (cfg->is_link_irq)
+		cfg->irq_mask |= BIT(cfg->link_irq_vec);
+
 	cfg->link_speed_msk &= self->aq_hw_caps.link_speed_msk;
 	cfg->hw_features = self->aq_hw_caps.hw_features;
 	return 0;
 }
 
-static void aq_nic_service_timer_cb(unsigned long param)
+/* Programs the static moderation on all rings, then lets vectors running
+ * dynamic moderation put their own profile back on the next poll.
+ */
+void aq_nic_update_interrupt_moderation(struct aq_nic_s *self)
 {
-	struct aq_nic_s *self = (struct aq_nic_s *)param;
-	struct net_device *ndev = aq_nic_get_ndev(self);
-	int err = 0;
-	bool is_busy = false;
+	struct aq_vec_s *aq_vec = NULL;
 	unsigned int i = 0U;
-	struct aq_hw_link_status_s link_status;
-	struct aq_ring_stats_rx_s stats_rx;
-	struct aq_ring_stats_tx_s stats_tx;
 
-	atomic_inc(&self->header.busy_count);
-	is_busy = true;
-	if (aq_utils_obj_test(&self->header.flags, AQ_NIC_FLAGS_IS_NOT_READY))
-		goto err_exit;
+	self->aq_hw_ops.hw_interrupt_moderation_set(self->aq_hw,
+			    self->aq_nic_cfg.is_interrupt_moderation);
+
+	for (i = 0U, aq_vec = self->aq_vec[0];
+		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i])
+		aq_vec_dim_reset(aq_vec);
+}
+
+static int aq_nic_update_link_status(struct aq_nic_s *self)
+{
+	struct aq_hw_link_status_s link_status;
+	int err = 0;
 
 	err = self->aq_hw_ops.hw_get_link_status(self->aq_hw, &link_status);
 	if (err < 0)
 		goto err_exit;
 
-	self->aq_hw_ops.hw_interrupt_moderation_set(self->aq_hw,
-			    self->aq_nic_cfg.is_interrupt_moderation);
+	if (!memcmp(&link_status, &self->link_status, sizeof(link_status)))
+		goto err_exit;
 
-	if (memcmp(&link_status, &self->link_status, sizeof(link_status))) {
-		if (link_status.mbps) {
-			aq_utils_obj_set(&self->header.flags,
-					 AQ_NIC_FLAG_STARTED);
-			aq_utils_obj_clear(&self->header.flags,
-					   AQ_NIC_LINK_DOWN);
-			netif_carrier_on(self->ndev);
-		} else {
-			netif_carrier_off(self->ndev);
-			aq_utils_obj_set(&self->header.flags, AQ_NIC_LINK_DOWN);
-		}
+	/* Moderation timers depend on the link speed */
+	aq_nic_update_interrupt_moderation(self);
 
-		self->link_status = link_status;
+	if (link_status.mbps) {
+		aq_utils_obj_set(&self->header.flags, AQ_NIC_FLAG_STARTED);
+		aq_utils_obj_clear(&self->header.flags, AQ_NIC_LINK_DOWN);
+		netif_carrier_on(self->ndev);
+	} else {
+		netif_carrier_off(self->ndev);
+		aq_utils_obj_set(&self->header.flags, AQ_NIC_LINK_DOWN);
 	}
 
+	self->link_status = link_status;
+
+err_exit:
+	return err;
+}
+
+static irqreturn_t aq_nic_link_isr(int irq, void *private)
+{
+	struct aq_nic_s *self = private;
+
+	if (!self)
+		return IRQ_NONE;
+
+	if (!aq_utils_obj_test(&self->header.flags,
+			       AQ_NIC_FLAGS_IS_NOT_READY))
+		aq_nic_update_link_status(self);
+
+	self->aq_hw_ops.hw_irq_enable(self->aq_hw,
+				      BIT(self->aq_nic_cfg.link_irq_vec));
+
+	return IRQ_HANDLED;
+}
+
+static void aq_nic_service_task(struct work_struct *work)
+{
+	struct aq_nic_s *self = container_of(to_delayed_work(work),
+					     struct aq_nic_s, service_task);
+	struct net_device *ndev = aq_nic_get_ndev(self);
+	unsigned int i = 0U;
+	struct aq_ring_stats_rx_s stats_rx;
+	struct aq_ring_stats_tx_s stats_tx;
+
+	if (aq_utils_obj_test(&self->header.flags, AQ_NIC_FLAGS_IS_NOT_READY))
+		goto err_exit;
+
+	/* Without a link vector the link is still polled from here */
+	if (!self->aq_nic_cfg.is_link_irq)
+		aq_nic_update_link_status(self);
+
 	memset(&stats_rx, 0U, sizeof(struct aq_ring_stats_rx_s));
 	memset(&stats_tx, 0U, sizeof(struct aq_ring_stats_tx_s));
 	for (i = AQ_DIMOF(self->aq_vec); i--;) {
@@ -169,25 +300,18 @@ static void aq_nic_service_timer_cb(unsigned long param)
 	ndev->stats.tx_bytes = stats_tx.bytes;
 	ndev->stats.tx_errors = stats_tx.errors;
 
-err_exit:
-	if (is_busy)
-		atomic_dec(&self->header.busy_count);
-	mod_timer(&self->service_timer,
-		  jiffies + AQ_CFG_SERVICE_TIMER_INTERVAL);
-}
-
-static void aq_nic_polling_timer_cb(unsigned long param)
-{
-	struct aq_nic_s *self = (struct aq_nic_s *)param;
-	struct aq_vec_s *aq_vec = NULL;
-	unsigned int i = 0U;
-
-	for (i = 0U, aq_vec = self->aq_vec[0];
-		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i])
-		aq_vec_isr(i, (void *)aq_vec);
+	/* IRQ affinity set from userspace, retried on the next run when rtnl
+	 * is busy. aq_nic_stop() cancels this task under rtnl.
+	 */
+	if (rtnl_trylock()) {
+		for (i = 0U; self->aq_vecs > i; ++i)
+			aq_vec_update_affinity(self->aq_vec[i]);
+		rtnl_unlock();
+	}
 
-	mod_timer(&self->polling_timer, jiffies +
-		AQ_CFG_POLLING_TIMER_INTERVAL);
+err_exit:
+	schedule_delayed_work(&self->service_task,
+			      AQ_CFG_SERVICE_TIMER_INTERVAL);
 }
 
 static struct net_device *aq_nic_ndev_alloc(void)
@@ -242,6 +366,64 @@ err_exit:
 	return self;
 }
 
+static enum cpuhp_state aq_nic_cpuhp_state;
+
+/* Re-homes the vectors of a running interface after CPU hotplug. The
+ * queue count is kept, vectors fold onto the CPUs that are left.
+ */
+static void aq_nic_cpuhp_work(struct work_struct *work)
+{
+	struct aq_nic_s *self = container_of(work, struct aq_nic_s,
+					     cpuhp_work);
+	struct aq_vec_s *aq_vec = NULL;
+	unsigned int i = 0U;
+
+	rtnl_lock();
+
+	if (!netif_running(self->ndev))
+		goto err_exit;
+
+	for (i = 0U, aq_vec = self->aq_vec[0];
+		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i]) {
+		unsigned int cpu = aq_nic_vec_cpu(self, i);
+
+		aq_vec_set_affinity(aq_vec, cpumask_of(cpu));
+
+		aq_pci_func_set_irq_affinity(self->aq_pci_func, i,
+					     aq_vec_get_affinity_mask(aq_vec));
+		if (self->aq_nic_cfg.is_tx_irq_separate)
+			aq_pci_func_set_irq_affinity(self->aq_pci_func,
+					self->aq_vecs + i,
+					aq_vec_get_affinity_mask(aq_vec));
+	}
+
+err_exit:
+	rtnl_unlock();
+}
+
+static int aq_nic_cpu_online(unsigned int cpu, struct hlist_node *node)
+{
+	struct aq_nic_s *self = hlist_entry_safe(node, struct aq_nic_s,
+						 cpuhp_node);
+
+	cpumask_clear_cpu(cpu, &self->cpus_dying);
+	schedule_work(&self->cpuhp_work);
+
+	return 0;
+}
+
+static int aq_nic_cpu_offline(unsigned int cpu, struct hlist_node *node)
+{
+	struct aq_nic_s *self = hlist_entry_safe(node, struct aq_nic_s,
+						 cpuhp_node);
+
+	/* Still in cpu_online_mask here, the work may run before it leaves */
+	cpumask_set_cpu(cpu, &self->cpus_dying);
+	schedule_work(&self->cpuhp_work);
+
+	return 0;
+}
+
 int aq_nic_ndev_register(struct aq_nic_s *self)
 {
 	int err = 0;
@@ -271,6 +453,16 @@ int aq_nic_ndev_register(struct aq_nic_s *self)
 	self->is_ndev_registered = true;
 	netif_carrier_off(self->ndev);
 
+	self->debugfs_dir = aq_debugfs_nic_init(self);
+
+	INIT_WORK(&self->cpuhp_work, aq_nic_cpuhp_work);
+	err = cpuhp_state_add_instance_nocalls(aq_nic_cpuhp_state,
+					       &self->cpuhp_node);
+	if (err < 0)
+		goto err_exit;
+
+	self->is_cpuhp_added = true;
+
 	for (i = AQ_CFG_VECS_MAX; i--;)
 		aq_nic_ndev_queue_stop(self, i);
 
@@ -296,8 +488,20 @@ void aq_nic_ndev_free(struct aq_nic_s *self)
 	if (!self->ndev)
 		goto err_exit;
 
-	if (self->is_ndev_registered)
+	aq_debugfs_nic_exit(self->debugfs_dir);
+	self->debugfs_dir = NULL;
+
+	if (self->is_cpuhp_added)
+		cpuhp_state_remove_instance_nocalls(aq_nic_cpuhp_state,
+						    &self->cpuhp_node);
+
+	if (self->is_ndev_registered) {
+		cancel_work_sync(&self->cpuhp_work);
 		unregister_netdev(self->ndev);
+	}
+
+	if (self->xdp_prog)
+		bpf_prog_put(self->xdp_prog);
 
 	if (self->aq_hw)
 		self->aq_hw_ops.destroy(self->aq_hw);
@@ -347,9 +551,109 @@ err_exit:
 	return self;
 }
 
+static enum hrtimer_restart aq_nic_tx_doorbell_timer_cb(struct hrtimer *timer)
+{
+	struct aq_ring_s *ring = container_of(timer, struct aq_ring_s,
+					      tx_doorbell_timer);
+	struct aq_nic_s *self = ring->aq_nic;
+
+	/* aq_nic_xmit() holds the ring lock, it will ring the doorbell */
+	if (!spin_trylock(&ring->header.lock)) {
+		hrtimer_forward_now(timer, ns_to_ktime(NSEC_PER_USEC));
+		return HRTIMER_RESTART;
+	}
+
+	if (ring->tx_tail_pending) {
+		ring->tx_tail_pending = 0U;
+		self->aq_hw_ops.hw_ring_tx_tail_update(self->aq_hw, ring);
+	}
+
+	spin_unlock(&ring->header.lock);
+
+	return HRTIMER_NORESTART;
+}
+
+/* CPU for vector idx. Online CPUs are taken in this order: one thread per
+ * core on the device's node, then on other nodes, then the hyperthread
+ * siblings likewise. base_cpu_number skips the first entries.
+ *
+ * The hotplug lock keeps the cpuhp callbacks, and with them cpus_dying
+ * and the online mask, still for the walk.
+ */
+unsigned int aq_nic_vec_cpu(struct aq_nic_s *self, unsigned int idx)
+{
+	int node = dev_to_node(aq_nic_get_dev(self));
+	unsigned int cpus = 0U;
+	unsigned int cpu = 0U;
+	unsigned int pass = 0U;
+
+	cpus_read_lock();
+
+	for_each_online_cpu(cpu)
+		if (!cpumask_test_cpu(cpu, &self->cpus_dying))
+			++cpus;
+
+	if (!cpus)
+		goto err_first;
+
+	idx += self->aq_nic_cfg.aq_rss.base_cpu_number;
+	idx %= cpus;
+
+	for (pass = 0U; pass < 4U; ++pass) {
+		for_each_online_cpu(cpu) {
+			bool is_local = (node == NUMA_NO_NODE) ||
+					(cpu_to_node(cpu) == node);
+			bool is_primary =
+				cpumask_first(topology_sibling_cpumask(cpu)) ==
+				cpu;
+
+			if (cpumask_test_cpu(cpu, &self->cpus_dying) ||
+			    is_local != !(pass & 1U) ||
+			    is_primary != (pass < 2U))
+				continue;
+
+			if (!idx--)
+				goto err_exit;
+		}
+	}
+
+err_first:
+	cpu = cpumask_first(cpu_online_mask);
+
+err_exit:
+	cpus_read_unlock();
+	return cpu;
+}
+
+int aq_nic_cpuhp_init(void)
+{
+	int err = 0;
+
+	err = cpuhp_setup_state_multi(CPUHP_AP_ONLINE_DYN,
+				      AQ_CFG_DRV_NAME ":online",
+				      aq_nic_cpu_online, aq_nic_cpu_offline);
+	if (err < 0)
+		goto err_exit;
+
+	aq_nic_cpuhp_state = err;
+	err = 0;
+
+err_exit:
+	return err;
+}
+
+void aq_nic_cpuhp_exit(void)
+{
+	cpuhp_remove_multi_state(aq_nic_cpuhp_state);
+}
+
 void aq_nic_set_tx_ring(struct aq_nic_s *self, unsigned int idx,
 			struct aq_ring_s *ring)
 {
+	hrtimer_init(&ring->tx_doorbell_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL);
+	ring->tx_doorbell_timer.function = aq_nic_tx_doorbell_timer_cb;
+
 	self->aq_ring_tx[idx] = ring;
 }
 
@@ -403,6 +707,8 @@ int aq_nic_start(struct aq_nic_s *self)
 	int err = 0;
 	unsigned int i = 0U;
 
+	aq_utils_obj_clear(&self->header.flags, AQ_NIC_FLAG_STOPPING);
+
 	err = self->aq_hw_ops.hw_multicast_list_set(self->aq_hw,
 						    self->mc_list.ar,
 						    self->mc_list.count);
@@ -429,35 +735,55 @@ int aq_nic_start(struct aq_nic_s *self)
 			    self->aq_nic_cfg.is_interrupt_moderation);
 	if (err < 0)
 		goto err_exit;
-	setup_timer(&self->service_timer, &aq_nic_service_timer_cb,
-		    (unsigned long)self);
-	mod_timer(&self->service_timer, jiffies +
-			AQ_CFG_SERVICE_TIMER_INTERVAL);
+	INIT_DELAYED_WORK(&self->service_task, aq_nic_service_task);
+	schedule_delayed_work(&self->service_task,
+			      AQ_CFG_SERVICE_TIMER_INTERVAL);
 
-	if (self->aq_nic_cfg.is_polling) {
-		setup_timer(&self->polling_timer, &aq_nic_polling_timer_cb,
-			    (unsigned long)self);
-		mod_timer(&self->polling_timer, jiffies +
-			  AQ_CFG_POLLING_TIMER_INTERVAL);
-	} else {
+	/* In polling mode each vector runs its own hrtimer, see aq_vec_start */
+	if (!self->aq_nic_cfg.is_polling) {
 		for (i = 0U, aq_vec = self->aq_vec[0];
 			self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i]) {
 			err = aq_pci_func_alloc_irq(self->aq_pci_func, i,
 						    self->ndev->name, aq_vec,
-					aq_vec_get_affinity_mask(aq_vec));
+					aq_vec_get_affinity_mask(aq_vec),
+					aq_vec_get_affinity_notify(aq_vec));
+			if (err < 0)
+				goto err_exit;
+
+			if (!self->aq_nic_cfg.is_tx_irq_separate)
+				continue;
+
+			err = aq_pci_func_alloc_irq(self->aq_pci_func,
+						    self->aq_vecs + i,
+						    self->ndev->name, aq_vec,
+					aq_vec_get_affinity_mask(aq_vec), NULL);
+			if (err < 0)
+				goto err_exit;
+
+			aq_vec_set_tx_irq(aq_vec,
+					  aq_pci_func_get_irq(self->aq_pci_func,
+							self->aq_vecs + i));
+		}
+
+		if (self->aq_nic_cfg.is_link_irq) {
+			err = aq_pci_func_alloc_link_irq(self->aq_pci_func,
+					self->aq_nic_cfg.link_irq_vec,
+					self->ndev->name, aq_nic_link_isr,
+					self);
 			if (err < 0)
 				goto err_exit;
 		}
 
 		err = self->aq_hw_ops.hw_irq_enable(self->aq_hw,
-				    AQ_CFG_IRQ_MASK);
+				    self->aq_nic_cfg.irq_mask);
 		if (err < 0)
 			goto err_exit;
 	}
 
-	for (i = 0U, aq_vec = self->aq_vec[0];
-		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i])
-		aq_nic_ndev_queue_start(self, i);
+	/* The link may already be up, no event will report it */
+	err = aq_nic_update_link_status(self);
+	if (err < 0)
+		goto err_exit;
 
 	err = netif_set_real_num_tx_queues(self->ndev, self->aq_vecs);
 	if (err < 0)
@@ -467,6 +793,24 @@ int aq_nic_start(struct aq_nic_s *self)
 	if (err < 0)
 		goto err_exit;
 
+	/* XPS: send from the CPUs that service the queue's vector */
+	for (i = 0U, aq_vec = self->aq_vec[0];
+		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i]) {
+		err = netif_set_xps_queue(self->ndev,
+					  aq_vec_get_affinity_mask(aq_vec), i);
+		if (err < 0)
+			goto err_exit;
+	}
+
+	for (i = 0U, aq_vec = self->aq_vec[0];
+		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i]) {
+		aq_nic_ndev_queue_start(self, i);
+
+		/* Other devices may redirect XDP frames to us from now on */
+		rcu_assign_pointer(self->aq_ring_xdp[i],
+				   aq_vec_get_xdp_ring(aq_vec));
+	}
+
 err_exit:
 	return err;
 }
@@ -563,26 +907,239 @@ static unsigned int aq_nic_map_skb(struct aq_nic_s *self, struct sk_buff *skb,
 	return ret;
 }
 
+/* Reaps completed descriptors of a TX ring from the transmit path. The
+ * trylock keeps it from ever waiting on (or racing with) aq_vec_poll(); if
+ * the poller owns the ring it is doing this work anyway.
+ */
+static bool aq_nic_tx_reclaim(struct aq_nic_s *self, struct aq_ring_s *ring)
+{
+	bool is_reclaimed = false;
+	int err = 0;
+
+	if (!spin_trylock(&ring->tx_clean_lock))
+		goto err_exit;
+
+	if (self->aq_hw_ops.hw_ring_tx_head_update)
+		err = self->aq_hw_ops.hw_ring_tx_head_update(self->aq_hw, ring);
+
+	if (err >= 0 && ring->sw_head != ring->hw_head) {
+		aq_ring_tx_clean(ring, 0);
+		is_reclaimed = true;
+	}
+
+	spin_unlock(&ring->tx_clean_lock);
+
+err_exit:
+	return is_reclaimed;
+}
+
+/* Returns true if the ring has less than "needed" free descriptors even
+ * after an inline reclaim attempt, i.e. the queue has to be stopped. The
+ * reclaim never starts the queue, the caller just skips the stop.
+ */
+static bool aq_nic_tx_is_ring_full(struct aq_nic_s *self,
+				   struct aq_ring_s *ring,
+				   unsigned int needed)
+{
+	unsigned int avail = aq_ring_avail_dx(ring);
+
+	if (avail < AQ_CFG_TX_RECLAIM_THRESHOLD &&
+	    aq_nic_tx_reclaim(self, ring))
+		avail = aq_ring_avail_dx(ring);
+
+	return avail < needed;
+}
+
+/* Called under the ring lock after descriptors for "frags" buffers were
+ * written. The tail pointer write is skipped while the stack has more skbs
+ * queued for us (xmit_more) and, in doorbell coalescing mode, until either
+ * tx_doorbell_frames descriptors are pending or tx_doorbell_usecs elapsed.
+ */
+static int aq_nic_tx_doorbell(struct aq_nic_s *self, struct aq_ring_s *ring,
+			      unsigned int frags, bool is_more)
+{
+	int err = 0;
+
+	ring->tx_tail_pending += frags;
+
+	if (is_more)
+		goto err_exit;
+
+	if (ring->tx_doorbell_frames &&
+	    ring->tx_tail_pending < ring->tx_doorbell_frames) {
+		if (!hrtimer_active(&ring->tx_doorbell_timer))
+			hrtimer_start(&ring->tx_doorbell_timer,
+				      ns_to_ktime(ring->tx_doorbell_usecs *
+						  NSEC_PER_USEC),
+				      HRTIMER_MODE_REL);
+		goto err_exit;
+	}
+
+	ring->tx_tail_pending = 0U;
+	err = self->aq_hw_ops.hw_ring_tx_tail_update(self->aq_hw, ring);
+
+err_exit:
+	return err;
+}
+
+/* Rings a deferred doorbell from outside the transmit path, e.g. when NAPI
+ * sees that the hardware drained everything it was told about.
+ */
+void aq_nic_tx_doorbell_flush(struct aq_nic_s *self, struct aq_ring_s *ring)
+{
+	if (!spin_trylock_bh(&ring->header.lock))
+		goto err_exit;
+
+	if (ring->tx_tail_pending) {
+		ring->tx_tail_pending = 0U;
+		self->aq_hw_ops.hw_ring_tx_tail_update(self->aq_hw, ring);
+	}
+
+	spin_unlock_bh(&ring->header.lock);
+
+err_exit:;
+}
+
+
+/* Software Toeplitz over "data", same algorithm the RSS block applies to
+ * received packets. The key must be at least len + 4 bytes long.
+ */
+static u32 aq_nic_rss_toeplitz(const u8 *key, const u8 *data,
+			       unsigned int len)
+{
+	u32 v = (key[0] << 24) | (key[1] << 16) | (key[2] << 8) | key[3];
+	u32 hash = 0U;
+	unsigned int i = 0U;
+	unsigned int bit = 0U;
+
+	for (i = 0U; i < len; ++i) {
+		for (bit = 0U; bit < 8U; ++bit) {
+			if (data[i] & (0x80U >> bit))
+				hash ^= v;
+			v <<= 1;
+			if (key[i + 4U] & (0x80U >> bit))
+				v |= 1U;
+		}
+	}
+
+	return hash;
+}
+
+/* RSS hash the hardware computes for packets of the reverse direction of
+ * the flow "skb" belongs to, i.e. for the replies we are going to receive.
+ */
+static u32 aq_nic_rss_hash_reverse(struct aq_nic_s *self, struct sk_buff *skb)
+{
+	const u8 *key = (const u8 *)self->aq_nic_cfg.aq_rss.hash_secret_key;
+	struct flow_keys keys;
+	u8 data[2U * sizeof(struct in6_addr) + 2U * sizeof(__be16)];
+	unsigned int len = 0U;
+	unsigned int addr_len = 0U;
+	u32 hash = 0U;
+
+	if (!skb_flow_dissect_flow_keys(skb, &keys, 0))
+		goto err_exit;
+
+	switch (keys.control.addr_type) {
+	case FLOW_DISSECTOR_KEY_IPV4_ADDRS:
+		addr_len = sizeof(keys.addrs.v4addrs.dst);
+		memcpy(&data[0], &keys.addrs.v4addrs.dst, addr_len);
+		memcpy(&data[addr_len], &keys.addrs.v4addrs.src, addr_len);
+		break;
+
+	case FLOW_DISSECTOR_KEY_IPV6_ADDRS:
+		addr_len = sizeof(keys.addrs.v6addrs.dst);
+		memcpy(&data[0], &keys.addrs.v6addrs.dst, addr_len);
+		memcpy(&data[addr_len], &keys.addrs.v6addrs.src, addr_len);
+		break;
+
+	default:
+		goto err_exit;
+	}
+	len = 2U * addr_len;
+
+	if (keys.basic.ip_proto == IPPROTO_TCP ||
+	    keys.basic.ip_proto == IPPROTO_UDP) {
+		memcpy(&data[len], &keys.ports.dst, sizeof(keys.ports.dst));
+		len += sizeof(keys.ports.dst);
+		memcpy(&data[len], &keys.ports.src, sizeof(keys.ports.src));
+		len += sizeof(keys.ports.src);
+	}
+
+	hash = aq_nic_rss_toeplitz(key, data, len);
+
+err_exit:
+	return hash;
+}
+
+/* Flow-affine TX queue selection: a flow is sent on the queue paired with
+ * the RX queue RSS steers its replies to, so both directions of a
+ * connection are processed by the same vector and CPU.
+ */
+u16 aq_nic_select_queue(struct aq_nic_s *self, struct sk_buff *skb,
+			select_queue_fallback_t fallback)
+{
+	struct aq_rss_parameters *rss_params = &self->aq_nic_cfg.aq_rss;
+	struct sock *sk = skb->sk;
+	unsigned int queue = 0U;
+	u32 hash = 0U;
+
+	if (!self->aq_nic_cfg.is_tx_flow_affine || !self->aq_nic_cfg.is_rss)
+		goto err_fallback;
+
+	if (skb_rx_queue_recorded(skb)) {
+		queue = skb_get_rx_queue(skb);
+		goto err_check;
+	}
+
+#ifdef CONFIG_RPS
+	/* hash of the last packet received on this socket, from HW RSS */
+	if (sk && sk_fullsock(sk))
+		hash = READ_ONCE(sk->sk_rxhash);
+#endif
+	if (!hash)
+		hash = aq_nic_rss_hash_reverse(self, skb);
+	if (!hash)
+		goto err_fallback;
+
+	queue = rss_params->indirection_table[hash %
+				rss_params->indirection_table_size];
+
+err_check:
+	if (queue < self->ndev->real_num_tx_queues)
+		goto err_exit;
+
+err_fallback:
+	queue = fallback(self->ndev, skb);
+
+err_exit:
+	return queue;
+}
+
 int aq_nic_xmit(struct aq_nic_s *self, struct sk_buff *skb)
 __releases(&ring->lock)
 __acquires(&ring->lock)
 {
 	struct aq_ring_s *ring = NULL;
 	unsigned int frags = 0U;
-	unsigned int vec = skb->queue_mapping % self->aq_nic_cfg.vecs;
+	unsigned int vec = skb->queue_mapping;
 	unsigned int tc = 0U;
 	unsigned int trys = AQ_CFG_LOCK_TRYS;
 	int err = 0;
 	bool is_nic_in_bad_state;
-	bool is_busy = false;
 	struct aq_ring_buff_s buffers[AQ_CFG_SKB_FRAGS_MAX];
 
 	frags = skb_shinfo(skb)->nr_frags + 1;
 
-	ring = self->aq_ring_tx[AQ_NIC_TCVEC2RING(self, tc, vec)];
+	/* The stack caps queue_mapping to real_num_tx_queues, which is set to
+	 * aq_vecs before any queue is started, so the queue index maps 1:1 to
+	 * the ring of the vector. No shared counter is touched here: stop
+	 * paths quiesce through the per-queue xmit locks of the stack.
+	 */
+	if (unlikely(vec >= self->aq_vecs))
+		vec %= self->aq_vecs;
 
-	atomic_inc(&self->header.busy_count);
-	is_busy = true;
+	ring = self->aq_ring_tx[AQ_NIC_TCVEC2RING(self, tc, vec)];
 
 	if (frags > AQ_CFG_SKB_FRAGS_MAX) {
 		dev_kfree_skb_any(skb);
@@ -591,8 +1148,8 @@ __acquires(&ring->lock)
 
 	is_nic_in_bad_state = aq_utils_obj_test(&self->header.flags,
 						AQ_NIC_FLAGS_IS_NOT_TX_READY) ||
-						(aq_ring_avail_dx(ring) <
-						AQ_CFG_SKB_FRAGS_MAX);
+						aq_nic_tx_is_ring_full(self,
+						ring, AQ_CFG_SKB_FRAGS_MAX);
 
 	if (is_nic_in_bad_state) {
 		aq_nic_ndev_queue_stop(self, ring->idx);
@@ -602,6 +1159,10 @@ __acquires(&ring->lock)
 
 	do {
 		if (spin_trylock(&ring->header.lock)) {
+			if (unlikely(smp_processor_id() !=
+				     READ_ONCE(ring->tx_clean_cpu)))
+				++ring->stats.tx.cross_cpu;
+
 			frags = aq_nic_map_skb(self, skb, &buffers[0]);
 
 			aq_ring_tx_append_buffs(ring, &buffers[0], frags);
@@ -609,9 +1170,19 @@ __acquires(&ring->lock)
 			err = self->aq_hw_ops.hw_ring_tx_xmit(self->aq_hw,
 							      ring, frags);
 			if (err >= 0) {
-				if (aq_ring_avail_dx(ring) <
-				    AQ_CFG_SKB_FRAGS_MAX + 1)
+				bool is_low = aq_ring_avail_dx(ring) <
+					      AQ_CFG_SKB_FRAGS_MAX + 1;
+				bool is_stopped = aq_nic_tx_is_ring_full(self,
+						ring, AQ_CFG_SKB_FRAGS_MAX + 1);
+
+				if (is_stopped)
 					aq_nic_ndev_queue_stop(self, ring->idx);
+				else if (is_low)
+					++ring->stats.tx.stops_avoided;
+
+				err = aq_nic_tx_doorbell(self, ring, frags,
+							 skb->xmit_more &&
+							 !is_stopped);
 			}
 			spin_unlock(&ring->header.lock);
 
@@ -629,11 +1200,110 @@ __acquires(&ring->lock)
 	}
 
 err_exit:
-	if (is_busy)
-		atomic_dec(&self->header.busy_count);
 	return err;
 }
 
+/* Sends a frame on an XDP TX ring. The ring is fed by the NAPI poll of its
+ * vector (XDP_TX) and by any CPU redirecting to us, hence the ring lock. The
+ * frame is sent from its page as is and released with page_frag_free() on
+ * completion. The doorbell is left pending until aq_nic_xdp_flush(), so a
+ * batch costs one tail write.
+ */
+int aq_nic_xdp_xmit(struct aq_nic_s *self, struct aq_ring_s *ring,
+		    struct xdp_buff *xdp)
+{
+	struct device *dev = aq_nic_get_dev(self);
+	unsigned int len = xdp->data_end - xdp->data;
+	struct aq_ring_buff_s buff;
+	int err = 0;
+
+	spin_lock(&ring->header.lock);
+
+	if (unlikely(aq_nic_tx_is_ring_full(self, ring, 1U))) {
+		err = -ENOSPC;
+		goto err_exit;
+	}
+
+	memset(&buff, 0, sizeof(buff));
+	buff.pa_xdp = dma_map_single(dev, xdp->data, len, DMA_TO_DEVICE);
+	if (unlikely(dma_mapping_error(dev, buff.pa_xdp))) {
+		err = -ENOMEM;
+		goto err_exit;
+	}
+
+	buff.xdp_data = xdp->data;
+	buff.len = len;
+	buff.is_sop = 1U;
+	buff.is_eop = 1U;
+	buff.is_mapped = 1U;
+	buff.is_xdp = 1U;
+
+	aq_ring_tx_append_buffs(ring, &buff, 1U);
+
+	/* The descriptor is written whatever the HW error flags say, the frame
+	 * belongs to the ring from here on.
+	 */
+	self->aq_hw_ops.hw_ring_tx_xmit(self->aq_hw, ring, 1U);
+	++ring->tx_tail_pending;
+
+	++ring->stats.tx.packets;
+	ring->stats.tx.bytes += len;
+
+err_exit:
+	if (err < 0)
+		++ring->stats.tx.errors;
+	spin_unlock(&ring->header.lock);
+	return err;
+}
+
+void aq_nic_xdp_flush(struct aq_nic_s *self, struct aq_ring_s *ring)
+{
+	spin_lock(&ring->header.lock);
+
+	if (ring->tx_tail_pending) {
+		ring->tx_tail_pending = 0U;
+		self->aq_hw_ops.hw_ring_tx_tail_update(self->aq_hw, ring);
+	}
+
+	spin_unlock(&ring->header.lock);
+}
+
+/* Frames redirected to us go to the XDP TX ring of the vector matching the
+ * sending CPU. There is none unless we run an XDP program ourselves and
+ * are started. Called under RCU from the sender's NAPI poll.
+ */
+static struct aq_ring_s *aq_nic_xdp_redirect_ring(struct aq_nic_s *self)
+{
+	unsigned int vecs = READ_ONCE(self->aq_vecs);
+
+	return vecs ? rcu_dereference(self->aq_ring_xdp[smp_processor_id() %
+							vecs]) : NULL;
+}
+
+int aq_nic_xdp_redirect_xmit(struct aq_nic_s *self, struct xdp_buff *xdp)
+{
+	struct aq_ring_s *ring = aq_nic_xdp_redirect_ring(self);
+	int err = 0;
+
+	if (unlikely(!ring)) {
+		err = -ENXIO;
+		goto err_exit;
+	}
+
+	err = aq_nic_xdp_xmit(self, ring, xdp);
+
+err_exit:
+	return err;
+}
+
+void aq_nic_xdp_redirect_flush(struct aq_nic_s *self)
+{
+	struct aq_ring_s *ring = aq_nic_xdp_redirect_ring(self);
+
+	if (ring)
+		aq_nic_xdp_flush(self, ring);
+}
+
 int aq_nic_set_packet_filter(struct aq_nic_s *self, unsigned int flags)
 {
 	int err = 0;
@@ -684,6 +1354,120 @@ int aq_nic_set_mac(struct aq_nic_s *self, struct net_device *ndev)
 	return self->aq_hw_ops.hw_set_mac_address(self->aq_hw, ndev->dev_addr);
 }
 
+/* XDP runs on single buffer frames, so LRO has to be off and the MTU has
+ * to fit one RX buffer. Attaching or detaching a program restarts the
+ * interface: RX buffers get or lose their headroom and the vectors their
+ * XDP TX rings. Replacing a program is done live.
+ */
+int aq_nic_xdp_setup(struct aq_nic_s *self, struct bpf_prog *prog,
+		     struct netlink_ext_ack *extack)
+{
+	struct aq_nic_cfg_s *cfg = &self->aq_nic_cfg;
+	struct net_device *ndev = self->ndev;
+	bool is_toggle = !self->xdp_prog != !prog;
+	bool is_restart = netif_running(ndev) && is_toggle;
+	struct bpf_prog *old_prog = NULL;
+	struct aq_vec_s *aq_vec = NULL;
+	unsigned int i = 0U;
+	int err = 0;
+
+	if (prog && cfg->is_lro) {
+		NL_SET_ERR_MSG(extack, "XDP is not supported with LRO");
+		err = -EOPNOTSUPP;
+		goto err_exit;
+	}
+
+	if (prog && cfg->mtu + VLAN_HLEN > AQ_CFG_RX_FRAME_MAX) {
+		NL_SET_ERR_MSG(extack, "MTU too large for XDP");
+		err = -EINVAL;
+		goto err_exit;
+	}
+
+	if (prog && AQ_NIC_TCVEC2RING(self, cfg->tcs - 1U, cfg->vecs - 1U) >=
+	    AQ_NIC_VEC2XDPRING(self->aq_hw_caps.vecs, cfg->vecs - 1U)) {
+		NL_SET_ERR_MSG(extack, "Not enough rings for XDP TX");
+		err = -EOPNOTSUPP;
+		goto err_exit;
+	}
+
+	if (is_restart)
+		ndev->netdev_ops->ndo_stop(ndev);
+
+	old_prog = xchg(&self->xdp_prog, prog);
+
+	if (is_restart) {
+		err = ndev->netdev_ops->ndo_open(ndev);
+		if (err < 0) {
+			/* The core drops its reference to prog on failure,
+			 * bring the interface back up with the old one and
+			 * report the first error.
+			 */
+			self->xdp_prog = old_prog;
+			ndev->netdev_ops->ndo_open(ndev);
+			goto err_exit;
+		}
+	} else if (netif_running(ndev)) {
+		for (i = 0U, aq_vec = self->aq_vec[0];
+			self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i])
+			aq_vec_set_xdp_prog(aq_vec, prog);
+	}
+
+	if (old_prog)
+		bpf_prog_put(old_prog);
+
+	/* Let aq_ndev_fix_features() mask or unmask LRO */
+	if (is_toggle)
+		netdev_update_features(ndev);
+
+err_exit:
+	return err;
+}
+
+/* Caller holds rtnl, vectors are reallocated by restarting the interface */
+int aq_nic_set_vecs(struct aq_nic_s *self, unsigned int vecs)
+{
+	struct aq_nic_cfg_s *cfg = &self->aq_nic_cfg;
+	struct net_device *ndev = self->ndev;
+	int err = 0;
+
+	if (!vecs || vecs > aq_nic_get_vecs_max(self)) {
+		err = -EINVAL;
+		goto err_exit;
+	}
+
+	if (vecs == cfg->vecs)
+		goto err_exit;
+
+	if (self->xdp_prog &&
+	    AQ_NIC_TCVEC2RING(self, cfg->tcs - 1U, vecs - 1U) >=
+	    AQ_NIC_VEC2XDPRING(self->aq_hw_caps.vecs, vecs - 1U)) {
+		err = -EOPNOTSUPP;
+		goto err_exit;
+	}
+
+	if (netif_running(ndev))
+		ndev->netdev_ops->ndo_stop(ndev);
+
+	cfg->vecs = vecs;
+	cfg->is_rss = AQ_CFG_IS_RSS_DEF;
+	err = aq_nic_cfg_start(self);
+
+	if (netif_running(ndev)) {
+		int err_open = ndev->netdev_ops->ndo_open(ndev);
+
+		if (err_open < 0)
+			err = err_open;
+	}
+
+err_exit:
+	return err;
+}
+
+struct bpf_prog *aq_nic_get_xdp_prog(struct aq_nic_s *self)
+{
+	return self->xdp_prog;
+}
+
 unsigned int aq_nic_get_link_speed(struct aq_nic_s *self)
 {
 	return self->link_status.mbps;
@@ -827,6 +1611,47 @@ err_exit:
 	return err;
 }
 
+void aq_nic_poll_show(struct aq_nic_s *self, struct seq_file *seq)
+{
+	struct aq_vec_s *aq_vec = NULL;
+	unsigned int i = 0U;
+
+	seq_printf(seq, "weight %u\n", self->aq_nic_cfg.napi_weight);
+	seq_puts(seq, "ring\tvec\ttc\tdeficit\tstarved\n");
+
+	for (i = 0U, aq_vec = self->aq_vec[0];
+		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i])
+		aq_vec_poll_show(aq_vec, seq);
+}
+
+/* Caller holds rtnl, vectors only exist while the interface is up */
+void aq_nic_moderation_show(struct aq_nic_s *self, struct seq_file *seq)
+{
+	struct aq_vec_s *aq_vec = NULL;
+	unsigned int i = 0U;
+
+	seq_printf(seq, "moderation %s\n",
+		   self->aq_nic_cfg.is_interrupt_moderation ? "on" : "off");
+	seq_puts(seq, "vec\trx_usecs\ttx_usecs\n");
+
+	for (i = 0U, aq_vec = self->aq_vec[0];
+		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i])
+		aq_vec_moderation_show(aq_vec, seq);
+}
+
+void aq_nic_numa_show(struct aq_nic_s *self, struct seq_file *seq)
+{
+	struct aq_vec_s *aq_vec = NULL;
+	unsigned int i = 0U;
+
+	seq_puts(seq, "ring\tvec\tcpu\tnode\t"
+		 "vec_mem\ttx_desc\trx_desc\trx_buff\n");
+
+	for (i = 0U, aq_vec = self->aq_vec[0];
+		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i])
+		aq_vec_numa_show(aq_vec, seq);
+}
+
 struct aq_nic_cfg_s *aq_nic_get_cfg(struct aq_nic_s *self)
 {
 	return &self->aq_nic_cfg;
@@ -846,17 +1671,35 @@ int aq_nic_stop(struct aq_nic_s *self)
 	struct aq_vec_s *aq_vec = NULL;
 	unsigned int i = 0U;
 
+	for (i = 0U; self->aq_vecs > i; ++i)
+		RCU_INIT_POINTER(self->aq_ring_xdp[i], NULL);
+
+	/* Let XDP redirects already on an XDP TX ring finish */
+	if (self->xdp_prog)
+		synchronize_rcu();
+
+	/* netif_tx_disable() waits for aq_nic_xmit() calls in flight, later
+	 * ones see the flag and leave the doorbell timers alone, even if a
+	 * last NAPI poll restarts the queue.
+	 */
+	aq_utils_obj_set(&self->header.flags, AQ_NIC_FLAG_STOPPING);
+	netif_tx_disable(self->ndev);
+
 	for (i = 0U, aq_vec = self->aq_vec[0];
-		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i])
-		aq_nic_ndev_queue_stop(self, i);
+		self->aq_vecs > i; ++i, aq_vec = self->aq_vec[i]) {
+		unsigned int tc = 0U;
+
+		for (tc = 0U; tc < self->aq_nic_cfg.tcs; ++tc)
+			hrtimer_cancel(&self->aq_ring_tx[
+				AQ_NIC_TCVEC2RING(self, tc, i)]->
+				tx_doorbell_timer);
+	}
 
-	del_timer_sync(&self->service_timer);
+	cancel_delayed_work_sync(&self->service_task);
 
-	self->aq_hw_ops.hw_irq_disable(self->aq_hw, AQ_CFG_IRQ_MASK);
+	self->aq_hw_ops.hw_irq_disable(self->aq_hw, self->aq_nic_cfg.irq_mask);
 
-	if (self->aq_nic_cfg.is_polling)
-		del_timer_sync(&self->polling_timer);
-	else
+	if (!self->aq_nic_cfg.is_polling)
 		aq_pci_func_free_irqs(self->aq_pci_func);
 
 	for (i = 0U, aq_vec = self->aq_vec[0];
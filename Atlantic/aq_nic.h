@@ -18,6 +18,10 @@
 struct aq_ring_s;
 struct aq_pci_func_s;
 struct aq_hw_ops;
+struct seq_file;
+struct bpf_prog;
+struct xdp_buff;
+struct netlink_ext_ack;
 
 #define AQ_NIC_FC_OFF    0U
 #define AQ_NIC_FC_TX     1U
@@ -39,13 +43,22 @@ struct aq_nic_cfg_s {
 	u32 txds;		/* tx ring size, descriptors # */
 	u32 vecs;		/* vecs==allocated irqs */
 	u32 irq_type;
-	u32 itr;
+	u32 irq_mask;		/* ring and link vectors in use */
+	u32 link_irq_vec;
+	u32 rx_itr[AQ_CFG_VECS_MAX];	/* per queue usecs or AQ_CFG_ITR_AUTO */
+	u32 tx_itr[AQ_CFG_VECS_MAX];
+	u32 rx_dim_mask;	/* queues under dynamic moderation */
+	u32 tx_dim_mask;
 	u32 num_rss_queues;
 	u32 mtu;
 	u32 ucp_0x364;
 	u32 flow_control;
 	u32 link_speed_msk;
 	u32 vlan_id;
+	u32 tx_doorbell_frames;
+	u32 tx_doorbell_usecs;
+	u32 polling_usecs;
+	u32 napi_weight;
 	u16 is_mc_list_enabled;
 	u16 mc_list_count;
 	bool is_autoneg;
@@ -53,6 +66,10 @@ struct aq_nic_cfg_s {
 	bool is_polling;
 	bool is_rss;
 	bool is_lro;
+	bool is_tx_flow_affine;
+	bool is_tx_irq_separate;
+	bool is_napi_threaded;
+	bool is_link_irq;
 	u8  tcs;
 	struct aq_rss_parameters aq_rss;
 };
@@ -65,9 +82,18 @@ struct aq_nic_cfg_s {
 #define AQ_NIC_FLAG_ERR_UNPLUG  0x40000000U
 #define AQ_NIC_FLAG_ERR_HW      0x80000000U
 
+/* ethtool private flags */
+#define AQ_NIC_PRIV_FLAG_TX_FLOW_AFFINE  BIT(0)
+#define AQ_NIC_PRIV_FLAG_TX_IRQ_SEPARATE BIT(1)
+#define AQ_NIC_PRIV_FLAG_NAPI_THREADED   BIT(2)
+#define AQ_NIC_PRIV_FLAG_POLLING         BIT(3)
+
 #define AQ_NIC_TCVEC2RING(_NIC_, _TC_, _VEC_) \
 	((_TC_) * AQ_CFG_TCS_MAX + (_VEC_))
 
+/* XDP TX rings are taken from the top of the hardware rings down */
+#define AQ_NIC_VEC2XDPRING(_RINGS_, _VEC_) ((_RINGS_) - 1U - (_VEC_))
+
 struct aq_nic_s *aq_nic_alloc_cold(const struct net_device_ops *ndev_ops,
 				   const struct ethtool_ops *et_ops,
 				   struct device *dev,
@@ -76,11 +102,16 @@ struct aq_nic_s *aq_nic_alloc_cold(const struct net_device_ops *ndev_ops,
 				   const struct aq_hw_ops *aq_hw_ops);
 int aq_nic_ndev_init(struct aq_nic_s *self);
 struct aq_nic_s *aq_nic_alloc_hot(struct net_device *ndev);
+unsigned int aq_nic_vec_cpu(struct aq_nic_s *self, unsigned int idx);
+void aq_nic_update_interrupt_moderation(struct aq_nic_s *self);
+int aq_nic_cpuhp_init(void);
+void aq_nic_cpuhp_exit(void);
 void aq_nic_set_tx_ring(struct aq_nic_s *self, unsigned int idx,
 			struct aq_ring_s *ring);
 struct device *aq_nic_get_dev(struct aq_nic_s *self);
 struct net_device *aq_nic_get_ndev(struct aq_nic_s *self);
 int aq_nic_init(struct aq_nic_s *self);
+unsigned int aq_nic_get_vecs_max(struct aq_nic_s *self);
 int aq_nic_cfg_start(struct aq_nic_s *self);
 int aq_nic_ndev_register(struct aq_nic_s *self);
 void aq_nic_ndev_queue_start(struct aq_nic_s *self, unsigned int idx);
@@ -88,6 +119,18 @@ void aq_nic_ndev_queue_stop(struct aq_nic_s *self, unsigned int idx);
 void aq_nic_ndev_free(struct aq_nic_s *self);
 int aq_nic_start(struct aq_nic_s *self);
 int aq_nic_xmit(struct aq_nic_s *self, struct sk_buff *skb);
+u16 aq_nic_select_queue(struct aq_nic_s *self, struct sk_buff *skb,
+			select_queue_fallback_t fallback);
+int aq_nic_xdp_xmit(struct aq_nic_s *self, struct aq_ring_s *ring,
+		    struct xdp_buff *xdp);
+void aq_nic_xdp_flush(struct aq_nic_s *self, struct aq_ring_s *ring);
+int aq_nic_xdp_redirect_xmit(struct aq_nic_s *self, struct xdp_buff *xdp);
+void aq_nic_xdp_redirect_flush(struct aq_nic_s *self);
+int aq_nic_xdp_setup(struct aq_nic_s *self, struct bpf_prog *prog,
+		     struct netlink_ext_ack *extack);
+int aq_nic_set_vecs(struct aq_nic_s *self, unsigned int vecs);
+struct bpf_prog *aq_nic_get_xdp_prog(struct aq_nic_s *self);
+void aq_nic_tx_doorbell_flush(struct aq_nic_s *self, struct aq_ring_s *ring);
 int aq_nic_get_regs(struct aq_nic_s *self, struct ethtool_regs *regs, void *p);
 int aq_nic_get_regs_count(struct aq_nic_s *self);
 void aq_nic_get_stats(struct aq_nic_s *self, u64 *data);
@@ -101,6 +144,9 @@ int aq_nic_set_multicast_list(struct aq_nic_s *self, struct net_device *ndev);
 unsigned int aq_nic_get_link_speed(struct aq_nic_s *self);
 void aq_nic_get_link_settings(struct aq_nic_s *self, struct ethtool_cmd *cmd);
 int aq_nic_set_link_settings(struct aq_nic_s *self, struct ethtool_cmd *cmd);
+void aq_nic_poll_show(struct aq_nic_s *self, struct seq_file *seq);
+void aq_nic_moderation_show(struct aq_nic_s *self, struct seq_file *seq);
+void aq_nic_numa_show(struct aq_nic_s *self, struct seq_file *seq);
 struct aq_nic_cfg_s *aq_nic_get_cfg(struct aq_nic_s *self);
 u32 aq_nic_get_fw_version(struct aq_nic_s *self);
 int aq_nic_change_pm_state(struct aq_nic_s *self, pm_message_t *pm_msg);
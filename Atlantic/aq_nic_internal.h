@@ -16,6 +16,7 @@ struct aq_nic_s {
 	struct aq_obj_s header;
 	struct aq_vec_s *aq_vec[AQ_CFG_VECS_MAX];
 	struct aq_ring_s *aq_ring_tx[AQ_CFG_VECS_MAX * AQ_CFG_TCS_MAX];
+	struct aq_ring_s __rcu *aq_ring_xdp[AQ_CFG_VECS_MAX]; /* started only */
 	struct aq_hw_s *aq_hw;
 	struct net_device *ndev;
 	struct aq_pci_func_s *aq_pci_func;
@@ -23,12 +24,17 @@ struct aq_nic_s {
 	unsigned int packet_filter;
 	unsigned int power_state;
 	bool is_ndev_registered;
+	bool is_cpuhp_added;
 	u8 port;
 	struct aq_hw_ops aq_hw_ops;
 	struct aq_hw_caps_s aq_hw_caps;
 	struct aq_nic_cfg_s aq_nic_cfg;
-	struct timer_list service_timer;
-	struct timer_list polling_timer;
+	struct bpf_prog *xdp_prog;
+	struct delayed_work service_task;
+	struct dentry *debugfs_dir;
+	struct hlist_node cpuhp_node;
+	struct work_struct cpuhp_work;
+	cpumask_t cpus_dying;	/* going offline, under the hotplug lock */
 	struct aq_hw_link_status_s link_status;
 	struct {
 		u32 count;
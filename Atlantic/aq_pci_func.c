@@ -23,12 +23,12 @@ struct aq_pci_func_s {
 	resource_size_t mmio_pa;
 	unsigned int msix_entry_mask;
 	unsigned int irq_type;
+	unsigned int irq_vecs;
 	unsigned int ports;
 	bool is_pci_enabled;
 	bool is_regions;
 	bool is_pci_using_dac;
 	struct aq_hw_caps_s aq_hw_caps;
-	struct msix_entry msix_entry[AQ_CFG_PCI_FUNC_MSIX_IRQS];
 };
 
 struct aq_pci_func_s *aq_pci_func_alloc(struct aq_hw_ops *aq_hw_ops,
@@ -87,7 +87,7 @@ int aq_pci_func_init(struct aq_pci_func_s *self)
 	int err = 0;
 	unsigned int bar = 0U;
 	unsigned int port = 0U;
-	unsigned int i = 0U;
+	unsigned int numvecs = 0U;
 
 	err = pci_enable_device(self->pdev);
 	if (err < 0)
@@ -147,31 +147,35 @@ int aq_pci_func_init(struct aq_pci_func_s *self)
 
 	if (err < 0)
 		goto err_exit;
-	for (i = 0; i < self->aq_hw_caps.msix_irqs; i++)
-		self->msix_entry[i].entry = i;
 
 	/*enable interrupts */
 #if AQ_CFG_FORCE_LEGACY_INT
-	self->irq_type = AQ_HW_IRQ_LEGACY;
+	err = pci_alloc_irq_vectors(self->pdev, 1, 1, PCI_IRQ_LEGACY);
 #else
-	 //err = pci_enable_msix(self->pdev, self->msix_entry,
-         //		      self->aq_hw_caps.msix_irqs);
-	err = pci_enable_msix_exact(self->pdev, self->msix_entry,
-			      self->aq_hw_caps.msix_irqs);
+	/* One vector per ring pair, one more per TX ring if TX completions
+	 * get their own vectors, plus the link/error vector.
+	 */
+	numvecs = min_t(unsigned int, self->aq_hw_caps.msix_irqs,
+			AQ_CFG_PCI_FUNC_MSIX_IRQS);
+	numvecs = min(numvecs, 2U * num_online_cpus() + 1U);
+
+	err = pci_alloc_irq_vectors(self->pdev, 1, numvecs, PCI_IRQ_MSIX);
+	if (err < 0)
+		err = pci_alloc_irq_vectors(self->pdev, 1, 1,
+					    PCI_IRQ_MSI | PCI_IRQ_LEGACY);
+#endif
+	if (err < 0)
+		goto err_exit;
 
-	if (err >= 0) {
+	self->irq_vecs = err;
+	err = 0;
+
+	if (self->pdev->msix_enabled)
 		self->irq_type = AQ_HW_IRQ_MSIX;
-	} else {
-		err = pci_enable_msi(self->pdev);
-
-		if (err >= 0) {
-			self->irq_type = AQ_HW_IRQ_MSI;
-		} else {
-			self->irq_type = AQ_HW_IRQ_LEGACY;
-			err = 0;
-		}
-	}
-#endif
+	else if (self->pdev->msi_enabled)
+		self->irq_type = AQ_HW_IRQ_MSI;
+	else
+		self->irq_type = AQ_HW_IRQ_LEGACY;
 
 	/* net device init */
 	for (port = 0; port < self->ports; ++port) {
@@ -198,13 +202,19 @@ err_exit:
 }
 
 int aq_pci_func_alloc_irq(struct aq_pci_func_s *self, unsigned int i,
-			  char *name, void *aq_vec, cpumask_t *affinity_mask)
+			  char *name, void *aq_vec, cpumask_t *affinity_mask,
+			  struct irq_affinity_notify *affinity_notify)
 {
 	int err = 0;
 
+	if (i >= self->irq_vecs && self->irq_type == AQ_HW_IRQ_MSIX) {
+		err = -EINVAL;
+		goto err_exit;
+	}
+
 	switch (self->irq_type) {
 	case AQ_HW_IRQ_MSIX:
-		err = request_irq(self->msix_entry[i].vector, aq_vec_isr, 0,
+		err = request_irq(pci_irq_vector(self->pdev, i), aq_vec_isr, 0,
 				  name, aq_vec);
 		break;
 
@@ -223,17 +233,64 @@ int aq_pci_func_alloc_irq(struct aq_pci_func_s *self, unsigned int i,
 	}
 
 	if (err >= 0) {
-		self->msix_entry_mask |= (1 << i);
+		self->msix_entry_mask |= (1U << i);
 		self->aq_vec[i] = aq_vec;
 
-		if (self->irq_type == AQ_HW_IRQ_MSIX)
-			irq_set_affinity_hint(self->msix_entry[i].vector,
+		if (self->irq_type == AQ_HW_IRQ_MSIX) {
+			irq_set_affinity_hint(pci_irq_vector(self->pdev, i),
 					      affinity_mask);
+			if (affinity_notify)
+				irq_set_affinity_notifier(
+					pci_irq_vector(self->pdev, i),
+					affinity_notify);
+		}
 	}
 
+err_exit:
 	return err;
 }
 
+/* The link vector is MSI-X only and handled in a thread, the hardware
+ * keeps it masked until the handler re-enables it.
+ */
+int aq_pci_func_alloc_link_irq(struct aq_pci_func_s *self, unsigned int i,
+			       char *name, irq_handler_t thread_fn,
+			       void *irq_arg)
+{
+	int err = 0;
+
+	if (i >= self->irq_vecs || self->irq_type != AQ_HW_IRQ_MSIX) {
+		err = -EINVAL;
+		goto err_exit;
+	}
+
+	err = request_threaded_irq(pci_irq_vector(self->pdev, i), NULL,
+				   thread_fn, IRQF_ONESHOT, name, irq_arg);
+	if (err < 0)
+		goto err_exit;
+
+	self->msix_entry_mask |= (1U << i);
+	self->aq_vec[i] = irq_arg;
+
+err_exit:
+	return err;
+}
+
+int aq_pci_func_get_irq(struct aq_pci_func_s *self, unsigned int i)
+{
+	return (self->irq_type == AQ_HW_IRQ_MSIX) ?
+		pci_irq_vector(self->pdev, i) : self->pdev->irq;
+}
+
+void aq_pci_func_set_irq_affinity(struct aq_pci_func_s *self,
+				  unsigned int i, cpumask_t *affinity_mask)
+{
+	if (self->irq_type == AQ_HW_IRQ_MSIX &&
+	    ((1U << i) & self->msix_entry_mask))
+		irq_set_affinity_hint(pci_irq_vector(self->pdev, i),
+				      affinity_mask);
+}
+
 void aq_pci_func_free_irqs(struct aq_pci_func_s *self)
 {
 	unsigned int i = 0U;
@@ -244,8 +301,12 @@ void aq_pci_func_free_irqs(struct aq_pci_func_s *self)
 
 		switch (self->irq_type) {
 		case AQ_HW_IRQ_MSIX:
-			irq_set_affinity_hint(self->msix_entry[i].vector, NULL);
-			free_irq(self->msix_entry[i].vector, self->aq_vec[i]);
+			irq_set_affinity_notifier(pci_irq_vector(self->pdev, i),
+						  NULL);
+			irq_set_affinity_hint(pci_irq_vector(self->pdev, i),
+					      NULL);
+			free_irq(pci_irq_vector(self->pdev, i),
+				 self->aq_vec[i]);
 			break;
 
 		case AQ_HW_IRQ_MSI:
@@ -274,6 +335,11 @@ unsigned int aq_pci_func_get_irq_type(struct aq_pci_func_s *self)
 	return self->irq_type;
 }
 
+unsigned int aq_pci_func_get_irq_vecs(struct aq_pci_func_s *self)
+{
+	return self->irq_vecs;
+}
+
 void aq_pci_func_deinit(struct aq_pci_func_s *self)
 {
 	if (!self)
@@ -281,20 +347,9 @@ void aq_pci_func_deinit(struct aq_pci_func_s *self)
 
 	aq_pci_func_free_irqs(self);
 
-	switch (self->irq_type) {
-	case AQ_HW_IRQ_MSI:
-		pci_disable_msi(self->pdev);
-		break;
-
-	case AQ_HW_IRQ_MSIX:
-		pci_disable_msix(self->pdev);
-		break;
-
-	case AQ_HW_IRQ_LEGACY:
-		break;
-
-	default:
-		break;
+	if (self->irq_vecs) {
+		pci_free_irq_vectors(self->pdev);
+		self->irq_vecs = 0U;
 	}
 
 	if (self->is_regions)
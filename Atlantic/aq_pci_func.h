@@ -14,6 +14,10 @@
 
 #include "aq_common.h"
 
+#include <linux/interrupt.h>
+
+struct irq_affinity_notify;
+
 struct aq_pci_func_s *aq_pci_func_alloc(struct aq_hw_ops *hw_ops,
 					struct pci_dev *pdev,
 					const struct net_device_ops *ndev_ops,
@@ -21,11 +25,19 @@ struct aq_pci_func_s *aq_pci_func_alloc(struct aq_hw_ops *hw_ops,
 int aq_pci_func_init(struct aq_pci_func_s *self);
 int aq_pci_func_alloc_irq(struct aq_pci_func_s *self, unsigned int i,
 			  char *name, void *aq_vec,
-			  cpumask_t *affinity_mask);
+			  cpumask_t *affinity_mask,
+			  struct irq_affinity_notify *affinity_notify);
+int aq_pci_func_alloc_link_irq(struct aq_pci_func_s *self, unsigned int i,
+			       char *name, irq_handler_t thread_fn,
+			       void *irq_arg);
+int aq_pci_func_get_irq(struct aq_pci_func_s *self, unsigned int i);
+void aq_pci_func_set_irq_affinity(struct aq_pci_func_s *self,
+				  unsigned int i, cpumask_t *affinity_mask);
 void aq_pci_func_free_irqs(struct aq_pci_func_s *self);
 int aq_pci_func_start(struct aq_pci_func_s *self);
 void __iomem *aq_pci_func_get_mmio(struct aq_pci_func_s *self);
 unsigned int aq_pci_func_get_irq_type(struct aq_pci_func_s *self);
+unsigned int aq_pci_func_get_irq_vecs(struct aq_pci_func_s *self);
 void aq_pci_func_deinit(struct aq_pci_func_s *self);
 void aq_pci_func_free(struct aq_pci_func_s *self);
 int aq_pci_func_change_pm_state(struct aq_pci_func_s *self,
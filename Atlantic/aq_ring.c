@@ -15,6 +15,9 @@
 
 #include <linux/netdevice.h>
 #include <linux/etherdevice.h>
+#include <linux/filter.h>
+#include <linux/bpf_trace.h>
+#include <net/busy_poll.h>
 
 static struct aq_ring_s *aq_ring_alloc(struct aq_ring_s *self,
 				       struct aq_nic_s *aq_nic)
@@ -22,15 +25,18 @@ static struct aq_ring_s *aq_ring_alloc(struct aq_ring_s *self,
 	int err = 0;
 
 	self->buff_ring =
-		kcalloc(self->size, sizeof(struct aq_ring_buff_s), GFP_KERNEL);
+		kcalloc_node(self->size, sizeof(struct aq_ring_buff_s),
+			     GFP_KERNEL, self->numa_node);
 
 	if (!self->buff_ring) {
 		err = -ENOMEM;
 		goto err_exit;
 	}
+
+	/* Descriptors stay on the device's node, buffers follow the vector */
 	self->dx_ring = dma_alloc_coherent(aq_nic_get_dev(aq_nic),
-						self->size * self->dx_size,
-						&self->dx_ring_pa, GFP_KERNEL);
+					   self->size * self->dx_size,
+					   &self->dx_ring_pa, GFP_KERNEL);
 	if (!self->dx_ring) {
 		err = -ENOMEM;
 		goto err_exit;
@@ -55,6 +61,8 @@ struct aq_ring_s *aq_ring_tx_alloc(struct aq_ring_s *self,
 	self->idx = idx;
 	self->size = aq_nic_cfg->txds;
 	self->dx_size = aq_nic_cfg->aq_hw_caps->txd_size;
+	self->tx_doorbell_frames = aq_nic_cfg->tx_doorbell_frames;
+	self->tx_doorbell_usecs = aq_nic_cfg->tx_doorbell_usecs;
 
 	self = aq_ring_alloc(self, aq_nic);
 	if (!self) {
@@ -81,6 +89,8 @@ struct aq_ring_s *aq_ring_rx_alloc(struct aq_ring_s *self,
 	self->idx = idx;
 	self->size = aq_nic_cfg->rxds;
 	self->dx_size = aq_nic_cfg->aq_hw_caps->rxd_size;
+	self->xdp_prog = aq_nic_get_xdp_prog(aq_nic);
+	self->rx_headroom = self->xdp_prog ? XDP_PACKET_HEADROOM : 0U;
 
 	self = aq_ring_alloc(self, aq_nic);
 	if (!self) {
@@ -88,6 +98,17 @@ struct aq_ring_s *aq_ring_rx_alloc(struct aq_ring_s *self,
 		goto err_exit;
 	}
 
+	if (self->xdp_prog) {
+		self->rx_page_cache = kcalloc_node(AQ_CFG_RX_PAGE_CACHE,
+						   sizeof(struct page *),
+						   GFP_KERNEL,
+						   self->numa_node);
+		if (!self->rx_page_cache) {
+			err = -ENOMEM;
+			goto err_exit;
+		}
+	}
+
 err_exit:
 	if (err < 0) {
 		aq_ring_free(self);
@@ -101,6 +122,10 @@ int aq_ring_init(struct aq_ring_s *self)
 	self->hw_head = 0;
 	self->sw_head = 0;
 	self->sw_tail = 0;
+	self->tx_tail_pending = 0;
+	self->tx_clean_cpu = self->cpu;
+	spin_lock_init(&self->header.lock);
+	spin_lock_init(&self->tx_clean_lock);
 	return 0;
 }
 
@@ -123,13 +148,24 @@ void aq_ring_tx_append_buffs(struct aq_ring_s *self,
 	}
 }
 
-int aq_ring_tx_clean(struct aq_ring_s *self)
+/* Walks completed descriptors from sw_head up to hw_head in two passes.
+ * The first unmaps the buffers in ring order while the descriptors are
+ * still hot in cache, the second releases the skbs through
+ * napi_consume_skb() so that, when called from NAPI (budget != 0), they go
+ * to the per-CPU skb cache and are freed in bulk instead of taking the
+ * dev_kfree_skb_any() irqs_disabled() path per packet.
+ */
+bool aq_ring_tx_clean(struct aq_ring_s *self, int budget)
 {
 	struct device *dev = aq_nic_get_dev(self->aq_nic);
+	unsigned int sw_head = self->sw_head;
+	unsigned int hw_head = self->hw_head;
+	unsigned int end = sw_head;
+	unsigned int tx_budget = AQ_CFG_TX_CLEAN_BUDGET;
 
-	for (; self->sw_head != self->hw_head;
-		self->sw_head = aq_ring_next_dx(self, self->sw_head)) {
-		struct aq_ring_buff_s *buff = &self->buff_ring[self->sw_head];
+	for (; end != hw_head && tx_budget;
+		end = aq_ring_next_dx(self, end)) {
+		struct aq_ring_buff_s *buff = &self->buff_ring[end];
 
 		if (likely(buff->is_mapped)) {
 			if (unlikely(buff->is_sop))
@@ -141,13 +177,24 @@ int aq_ring_tx_clean(struct aq_ring_s *self)
 		}
 
 		if (unlikely(buff->is_eop))
-			dev_kfree_skb_any(buff->skb);
+			--tx_budget;
 	}
 
-	if (aq_ring_avail_dx(self) > AQ_CFG_SKB_FRAGS_MAX)
-		aq_nic_ndev_queue_start(self->aq_nic, self->idx);
+	for (; sw_head != end; sw_head = aq_ring_next_dx(self, sw_head)) {
+		struct aq_ring_buff_s *buff = &self->buff_ring[sw_head];
 
-	return 0;
+		if (!buff->is_eop)
+			continue;
+
+		if (unlikely(buff->is_xdp))
+			page_frag_free(buff->xdp_data);
+		else
+			napi_consume_skb(buff->skb, budget);
+	}
+
+	self->sw_head = sw_head;
+
+	return sw_head == hw_head;
 }
 
 static inline unsigned int aq_ring_dx_in_range(unsigned int h, unsigned int i,
@@ -156,8 +203,72 @@ static inline unsigned int aq_ring_dx_in_range(unsigned int h, unsigned int i,
 	return (h < t) ? ((h < i) && (i < t)) : ((h < i) || (i < t));
 }
 
+/* Keeps a page XDP is done with for the next refill. The page is only
+ * reused when nobody else holds it and it sits on the ring's node.
+ */
+static void aq_ring_rx_recycle(struct aq_ring_s *self, struct page *page)
+{
+	if (self->rx_page_cached < AQ_CFG_RX_PAGE_CACHE &&
+	    page_ref_count(page) == 1 && !page_is_pfmemalloc(page) &&
+	    page_to_nid(page) == self->numa_node)
+		self->rx_page_cache[self->rx_page_cached++] = page;
+	else
+		put_page(page);
+}
+
+/* Runs the ring's XDP program, if any, on a single buffer frame. xdp is
+ * left describing the frame for the XDP_PASS path.
+ */
+static u32 aq_ring_rx_xdp(struct aq_ring_s *self, struct aq_ring_buff_s *buff,
+			  struct xdp_buff *xdp)
+{
+	struct net_device *ndev = aq_nic_get_ndev(self->aq_nic);
+	struct bpf_prog *xdp_prog = NULL;
+	u32 act = XDP_PASS;
+
+	xdp->data_hard_start = page_address(buff->page);
+	xdp->data = xdp->data_hard_start + self->rx_headroom;
+	xdp->data_end = xdp->data + buff->len;
+
+	rcu_read_lock();
+	xdp_prog = READ_ONCE(self->xdp_prog);
+	if (!xdp_prog)
+		goto err_exit;
+
+	act = bpf_prog_run_xdp(xdp_prog, xdp);
+	switch (act) {
+	case XDP_PASS:
+		break;
+	case XDP_TX:
+		if (aq_nic_xdp_xmit(self->aq_nic, self->xdp_tx_ring, xdp) < 0)
+			goto err_drop;
+		break;
+	case XDP_REDIRECT:
+		if (xdp_do_redirect(ndev, xdp, xdp_prog) < 0)
+			goto err_drop;
+		self->is_xdp_redirected = true;
+		break;
+	default:
+		bpf_warn_invalid_xdp_action(act);
+		/* fall through */
+	case XDP_ABORTED:
+err_drop:
+		trace_xdp_exception(ndev, xdp_prog, act);
+		act = XDP_DROP;
+		/* fall through */
+	case XDP_DROP:
+		aq_ring_rx_recycle(self, buff->page);
+		break;
+	}
+
+err_exit:
+	rcu_read_unlock();
+	return act;
+}
+
 #define AQ_SKB_ALIGN SKB_DATA_ALIGN(sizeof(struct skb_shared_info))
-int aq_ring_rx_clean(struct aq_ring_s *self, int *work_done, int budget)
+int aq_ring_rx_clean(struct aq_ring_s *self, struct napi_struct *napi,
+		     int *work_done, int budget)
 {
 	struct net_device *ndev = aq_nic_get_ndev(self->aq_nic);
 	int err = 0;
@@ -207,15 +318,25 @@ int aq_ring_rx_clean(struct aq_ring_s *self, int *work_done, int budget)
 
 		/* for single fragment packets use build_skb() */
 		if (buff->is_eop) {
-			skb = build_skb(page_address(buff->page),
-					buff->len + AQ_SKB_ALIGN);
+			struct xdp_buff xdp;
+
+			if (aq_ring_rx_xdp(self, buff, &xdp) != XDP_PASS) {
+				++self->stats.rx.packets;
+				self->stats.rx.bytes += buff->len;
+				continue;
+			}
+
+			skb = build_skb(xdp.data_hard_start,
+					xdp.data_end - xdp.data_hard_start +
+					AQ_SKB_ALIGN);
 			if (unlikely(!skb)) {
 				err = -ENOMEM;
 				goto err_exit;
 			}
 
 			skb->dev = ndev;
-			skb_put(skb, buff->len);
+			skb_reserve(skb, xdp.data - xdp.data_hard_start);
+			skb_put(skb, xdp.data_end - xdp.data);
 		} else {
 			skb = netdev_alloc_skb(ndev, ETH_HLEN);
 			if (unlikely(!skb)) {
@@ -223,9 +344,11 @@ int aq_ring_rx_clean(struct aq_ring_s *self, int *work_done, int budget)
 				goto err_exit;
 			}
 			skb_put(skb, ETH_HLEN);
-			memcpy(skb->data, page_address(buff->page), ETH_HLEN);
+			memcpy(skb->data, page_address(buff->page) +
+			       self->rx_headroom, ETH_HLEN);
 
-			skb_add_rx_frag(skb, 0, buff->page, ETH_HLEN,
+			skb_add_rx_frag(skb, 0, buff->page,
+					self->rx_headroom + ETH_HLEN,
 					buff->len - ETH_HLEN,
 					SKB_TRUESIZE(buff->len - ETH_HLEN));
 
@@ -233,8 +356,8 @@ int aq_ring_rx_clean(struct aq_ring_s *self, int *work_done, int budget)
 			     buff_ = &self->buff_ring[next_]; true;
 			     next_ = buff_->next,
 			     buff_ = &self->buff_ring[next_], ++i) {
-				skb_add_rx_frag(skb, i, buff_->page, 0,
-						buff_->len,
+				skb_add_rx_frag(skb, i, buff_->page,
+						self->rx_headroom, buff_->len,
 						SKB_TRUESIZE(buff->len -
 						ETH_HLEN));
 				buff_->is_cleaned = 1;
@@ -264,6 +387,7 @@ int aq_ring_rx_clean(struct aq_ring_s *self, int *work_done, int budget)
 			     PKT_HASH_TYPE_NONE);
 
 		skb_record_rx_queue(skb, self->idx);
+		skb_mark_napi_id(skb, napi);
 
 		netif_receive_skb(skb);
 
@@ -290,15 +414,19 @@ int aq_ring_rx_fill(struct aq_ring_s *self)
 		buff->flags = 0U;
 		buff->len = AQ_CFG_RX_FRAME_MAX;
 
-		buff->page = alloc_pages(GFP_ATOMIC | __GFP_COLD |
-					 __GFP_COMP, pages_order);
+		if (self->rx_page_cached)
+			buff->page = self->rx_page_cache[--self->rx_page_cached];
+		else
+			buff->page = alloc_pages_node(self->numa_node,
+						      GFP_ATOMIC | __GFP_COLD |
+						      __GFP_COMP, pages_order);
 		if (!buff->page) {
 			err = -ENOMEM;
 			goto err_exit;
 		}
 
 		buff->pa = dma_map_page(aq_nic_get_dev(self->aq_nic),
-					buff->page, 0,
+					buff->page, self->rx_headroom,
 					AQ_CFG_RX_FRAME_MAX, DMA_FROM_DEVICE);
 
 		err = dma_mapping_error(aq_nic_get_dev(self->aq_nic), buff->pa);
@@ -334,6 +462,9 @@ void aq_ring_rx_deinit(struct aq_ring_s *self)
 		__free_pages(buff->page, 0);
 	}
 
+	while (self->rx_page_cached)
+		put_page(self->rx_page_cache[--self->rx_page_cached]);
+
 err_exit:;
 }
 
@@ -357,8 +488,12 @@ void aq_ring_tx_deinit(struct aq_ring_s *self)
 			}
 		}
 
-		if (unlikely(buff->is_eop))
-			dev_kfree_skb_any(buff->skb);
+		if (unlikely(buff->is_eop)) {
+			if (unlikely(buff->is_xdp))
+				page_frag_free(buff->xdp_data);
+			else
+				dev_kfree_skb_any(buff->skb);
+		}
 	}
 err_exit:;
 }
@@ -369,6 +504,7 @@ void aq_ring_free(struct aq_ring_s *self)
 		goto err_exit;
 
 	kfree(self->buff_ring);
+	kfree(self->rx_page_cache);
 
 	if (self->dx_ring)
 		dma_free_coherent(aq_nic_get_dev(self->aq_nic),
@@ -14,7 +14,10 @@
 
 #include "aq_common.h"
 
+#include <linux/hrtimer.h>
+
 struct page;
+struct bpf_prog;
 
 /*           TxC       SOP        DX         EOP
  *         +----------+----------+----------+-----------
@@ -43,6 +46,11 @@ struct __packed aq_ring_buff_s {
 			dma_addr_t pa_eop;
 			struct sk_buff *skb;
 		};
+		/* XDP EOP */
+		struct {
+			dma_addr_t pa_xdp;
+			void *xdp_data;
+		};
 		/* DX */
 		struct {
 			dma_addr_t pa;
@@ -75,7 +83,8 @@ struct __packed aq_ring_buff_s {
 			u32 is_mapped:1;
 			u32 is_cleaned:1;
 			u32 is_error:1;
-			u32 rsvd3:6;
+			u32 is_xdp:1;
+			u32 rsvd3:5;
 		};
 		u32 flags;
 	};
@@ -87,12 +96,16 @@ struct aq_ring_stats_rx_s {
 	u64 bytes;
 	u64 lro_packets;
 	u64 jumbo_packets;
+	u64 starved;		/* polls that ran out of budget with work left */
 };
 
 struct aq_ring_stats_tx_s {
 	u64 errors;
 	u64 packets;
 	u64 bytes;
+	u64 stops_avoided;	/* queue stops prevented by inline reclaim */
+	u64 cross_cpu;		/* sent from a CPU other than the completing one */
+	u64 poll_contended;	/* polls that found the ring being reclaimed */
 };
 
 union aq_ring_stats_s {
@@ -106,6 +119,9 @@ struct aq_ring_s {
 	u8 *dx_ring;		/* descriptors ring, dma shared mem */
 	struct aq_nic_s *aq_nic;
 	unsigned int idx;	/* for HW layer registers operations */
+	unsigned int cpu;	/* CPU the ring's vector is serviced on */
+	unsigned int tx_clean_cpu;	/* CPU of the last completion poll */
+	int numa_node;		/* node of that CPU, for ring memory/pages */
 	unsigned int hw_head;
 	unsigned int sw_head;
 	unsigned int sw_tail;
@@ -114,11 +130,26 @@ struct aq_ring_s {
 				/* stored here for fater math */
 	union aq_ring_stats_s stats;
 	dma_addr_t dx_ring_pa;
+	int rx_deficit;		/* RX budget credit between TC rings */
+	struct bpf_prog *xdp_prog;	/* RX, RCU: swapped under the ring */
+	unsigned int rx_headroom;	/* XDP_PACKET_HEADROOM when XDP is on */
+	struct aq_ring_s *xdp_tx_ring;	/* XDP_TX goes to the vector's ring */
+	bool is_xdp_redirected;	/* XDP_REDIRECT done, flush after poll */
+	bool is_xdp;		/* TX ring carrying XDP_TX frames only */
+	struct page **rx_page_cache;	/* pages recycled from XDP_DROP */
+	unsigned int rx_page_cached;
+	spinlock_t tx_clean_lock; /* TX reclaim: NAPI poll vs aq_nic_xmit */
+	unsigned int tx_tail_pending;	/* written, not yet doorbelled */
+	unsigned int tx_doorbell_frames;	/* 0: doorbell every packet */
+	unsigned int tx_doorbell_usecs;
+	struct hrtimer tx_doorbell_timer;
 };
 
 struct aq_ring_param_s {
 	unsigned int vec_idx;
+	unsigned int tx_vec_idx;
 	unsigned int cpu;
+	int numa_node;
 	cpumask_t affinity_mask;
 };
 
@@ -128,6 +159,14 @@ static inline unsigned int aq_ring_next_dx(struct aq_ring_s *self,
 	return (++dx >= self->size) ? 0U : dx;
 }
 
+/* Tail index the hardware was last told about */
+static inline unsigned int aq_ring_tx_hw_tail(struct aq_ring_s *self)
+{
+	return (self->sw_tail >= self->tx_tail_pending) ?
+		self->sw_tail - self->tx_tail_pending :
+		self->size + self->sw_tail - self->tx_tail_pending;
+}
+
 static inline unsigned int aq_ring_avail_dx(struct aq_ring_s *self)
 {
 	return (((self->sw_tail >= self->sw_head)) ?
@@ -150,8 +189,9 @@ void aq_ring_free(struct aq_ring_s *self);
 void aq_ring_tx_append_buffs(struct aq_ring_s *ring,
 			     struct aq_ring_buff_s *buffer,
 			     unsigned int buffers);
-int aq_ring_tx_clean(struct aq_ring_s *self);
-int aq_ring_rx_clean(struct aq_ring_s *self, int *work_done, int budget);
+bool aq_ring_tx_clean(struct aq_ring_s *self, int budget);
+int aq_ring_rx_clean(struct aq_ring_s *self, struct napi_struct *napi,
+		     int *work_done, int budget);
 int aq_ring_rx_fill(struct aq_ring_s *self);
 
 #endif /* AQ_RING_H */
@@ -15,8 +15,13 @@
 #include "aq_nic.h"
 #include "aq_ring.h"
 #include "aq_hw.h"
+#include "aq_dim.h"
 
 #include <linux/netdevice.h>
+#include <linux/filter.h>
+#include <linux/kthread.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
 
 struct aq_vec_s {
 	struct aq_obj_s header;
@@ -26,98 +31,557 @@ struct aq_vec_s {
 	unsigned int tx_rings;
 	unsigned int rx_rings;
 	struct aq_ring_param_s aq_ring_param;
+	struct irq_affinity_notify affinity_notify;
+	struct completion affinity_released;	/* notifier kref dropped */
+	cpumask_t affinity_pending;	/* from the notifier, header.lock */
+	struct task_struct *poll_thread;
+	unsigned long poll_flags;
+	unsigned long poll_causes;	/* interrupts seen since last poll */
+	int tx_irq;		/* 0: TX completions share the vector IRQ */
+	u64 polls;
+	u64 mmio_reads;		/* register reads done by the poll */
+	unsigned int rx_next;	/* TC ring served first by the next poll */
+	bool is_napi_threaded;
+	bool is_polling;
+	struct hrtimer poll_timer;
+	struct aq_dim_s rx_dim;
+	struct aq_dim_s tx_dim;
+	u32 dim_events;		/* completed polls, i.e. interrupts */
 	struct napi_struct napi;
+	struct aq_ring_s xdp_ring;	/* XDP_TX, is_xdp when allocated */
 	struct aq_ring_s ring[AQ_CFG_TCS_MAX][2];
 };
 
 #define AQ_VEC_TX_ID 0
 #define AQ_VEC_RX_ID 1
 
-static int aq_vec_poll(struct napi_struct *napi, int budget)
-__releases(&self->lock)
-__acquires(&self->lock)
+/* poll_flags bits */
+#define AQ_VEC_POLL_PENDING 0
+#define AQ_VEC_DIM_RESET    1
+#define AQ_VEC_AFFINITY     2	/* affinity_pending not applied yet */
+
+/* poll_causes bits */
+#define AQ_VEC_CAUSE_RX 0
+#define AQ_VEC_CAUSE_TX 1
+#define AQ_VEC_CAUSES_ALL (BIT(AQ_VEC_CAUSE_RX) | BIT(AQ_VEC_CAUSE_TX))
+
+static void aq_vec_dim_sample(struct aq_vec_s *self, unsigned int id,
+			      struct aq_dim_sample_s *sample)
 {
-	struct aq_vec_s *self = container_of(napi, struct aq_vec_s, napi);
 	struct aq_ring_s *ring = NULL;
-	int work_done = 0;
+	unsigned int i = 0U;
+
+	memset(sample, 0, sizeof(*sample));
+	sample->time = ktime_get();
+	sample->events = self->dim_events;
+
+	for (i = 0U, ring = self->ring[0];
+		self->tx_rings > i; ++i, ring = self->ring[i]) {
+		if (id == AQ_VEC_RX_ID) {
+			sample->packets += ring[AQ_VEC_RX_ID].stats.rx.packets;
+			sample->bytes += ring[AQ_VEC_RX_ID].stats.rx.bytes;
+		} else {
+			sample->packets += ring[AQ_VEC_TX_ID].stats.tx.packets;
+			sample->bytes += ring[AQ_VEC_TX_ID].stats.tx.bytes;
+		}
+	}
+}
+
+/* Dynamic moderation, run once per interrupt before re-arming it */
+static void aq_vec_dim(struct aq_vec_s *self)
+{
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(self->aq_nic);
+	struct aq_dim_sample_s sample;
+	struct aq_ring_s *ring = NULL;
+	unsigned int i = 0U;
+	bool is_reset = test_and_clear_bit(AQ_VEC_DIM_RESET,
+					   &self->poll_flags);
+
+	if (!cfg->is_interrupt_moderation)
+		return;
+
+	++self->dim_events;
+
+	if ((cfg->rx_dim_mask & BIT(self->aq_ring_param.vec_idx)) &&
+	    self->aq_hw_ops->hw_ring_rx_moderation_set) {
+		if (is_reset)
+			aq_dim_init(&self->rx_dim);
+
+		aq_vec_dim_sample(self, AQ_VEC_RX_ID, &sample);
+		if (aq_dim_update(&self->rx_dim, &sample) || is_reset)
+			for (i = 0U, ring = self->ring[0];
+				self->rx_rings > i; ++i, ring = self->ring[i])
+				self->aq_hw_ops->hw_ring_rx_moderation_set(
+					self->aq_hw, &ring[AQ_VEC_RX_ID],
+					aq_dim_usecs(&self->rx_dim));
+	}
+
+	if ((cfg->tx_dim_mask & BIT(self->aq_ring_param.vec_idx)) &&
+	    self->aq_hw_ops->hw_ring_tx_moderation_set) {
+		if (is_reset)
+			aq_dim_init(&self->tx_dim);
+
+		aq_vec_dim_sample(self, AQ_VEC_TX_ID, &sample);
+		if (aq_dim_update(&self->tx_dim, &sample) || is_reset)
+			for (i = 0U, ring = self->ring[0];
+				self->tx_rings > i; ++i, ring = self->ring[i])
+				self->aq_hw_ops->hw_ring_tx_moderation_set(
+					self->aq_hw, &ring[AQ_VEC_TX_ID],
+					aq_dim_usecs(&self->tx_dim));
+	}
+}
+
+static void aq_vec_schedule(struct aq_vec_s *self, unsigned long causes);
+
+/* Reclaims a TX ring with frames in flight, is_pending is set when some
+ * are left for the next poll.
+ */
+static int aq_vec_tx_poll(struct aq_vec_s *self, struct aq_ring_s *ring,
+			  int budget, bool *is_pending)
+{
 	int err = 0;
+
+	if (ring->sw_head == ring->sw_tail)
+		goto err_exit;
+
+	if (spin_trylock(&ring->tx_clean_lock)) {
+		if (self->aq_hw_ops->hw_ring_tx_head_update) {
+			err = self->aq_hw_ops->hw_ring_tx_head_update(
+							self->aq_hw, ring);
+			++self->mmio_reads;
+		}
+
+		if (err >= 0 && ring->sw_head != ring->hw_head) {
+			/* Where completions really run, the IRQ may have been
+			 * moved away from ring->cpu.
+			 */
+			WRITE_ONCE(ring->tx_clean_cpu, raw_smp_processor_id());
+			if (!aq_ring_tx_clean(ring, budget))
+				*is_pending = true;
+		}
+		spin_unlock(&ring->tx_clean_lock);
+
+		/* Only the poll restarts the queue, aq_nic_xmit() reclaiming
+		 * inline just doesn't stop it.
+		 */
+		if (!ring->is_xdp &&
+		    aq_ring_avail_dx(ring) > AQ_CFG_SKB_FRAGS_MAX)
+			aq_nic_ndev_queue_start(self->aq_nic, ring->idx);
+
+		/* HW went idle with a coalesced doorbell pending */
+		if (ring->tx_tail_pending &&
+		    ring->hw_head == aq_ring_tx_hw_tail(ring))
+			aq_nic_tx_doorbell_flush(self->aq_nic, ring);
+	} else {
+		/* aq_nic_xmit() is reclaiming this ring inline,
+		 * stay scheduled and look at it again.
+		 */
+		++ring->stats.tx.poll_contended;
+		*is_pending = true;
+	}
+
+err_exit:
+	return err;
+}
+
+/* XDP_REDIRECT and XDP_TX frames of the poll go out in one go */
+static void aq_vec_xdp_flush(struct aq_vec_s *self)
+{
+	struct aq_ring_s *ring = NULL;
+	bool is_redirected = false;
 	unsigned int i = 0U;
+
+	for (i = 0U, ring = self->ring[0];
+		self->rx_rings > i; ++i, ring = self->ring[i]) {
+		is_redirected |= ring[AQ_VEC_RX_ID].is_xdp_redirected;
+		ring[AQ_VEC_RX_ID].is_xdp_redirected = false;
+	}
+
+	if (is_redirected)
+		xdp_do_flush_map();
+
+	aq_nic_xdp_flush(self->aq_nic, &self->xdp_ring);
+}
+
+/* Deficit round robin over the vector's TC rings, so a busy TC0 can't
+ * starve the others. Each round a ring with work earns budget/rx_rings
+ * of credit and may consume that much, an idle ring loses its credit,
+ * and the ring served first rotates between polls.
+ */
+static int aq_vec_rx_poll(struct aq_vec_s *self, int budget, int *work_done)
+{
+	int quantum = max_t(int, budget / (int)self->rx_rings, 1);
+	struct aq_ring_s *ring = NULL;
+	unsigned long pending = 0UL;	/* rings left with work */
 	unsigned int sw_tail_old = 0U;
-	bool was_tx_cleaned = false;
+	unsigned int tc = 0U;
+	unsigned int n = 0U;
+	bool is_progress = true;
+	int err = 0;
 
-	if (!self) {
-		err = -EINVAL;
-	} else if (spin_trylock(&self->header.lock)) {
-		for (i = 0U, ring = self->ring[0];
-			self->tx_rings > i; ++i, ring = self->ring[i]) {
-			if (self->aq_hw_ops->hw_ring_tx_head_update) {
-				err = self->aq_hw_ops->hw_ring_tx_head_update(
-							self->aq_hw,
-							&ring[AQ_VEC_TX_ID]);
-				if (err < 0)
-					goto err_exit;
-			}
+	while (is_progress && *work_done < budget) {
+		is_progress = false;
 
-			if (ring[AQ_VEC_TX_ID].sw_head !=
-				ring[AQ_VEC_TX_ID].hw_head) {
-				err = aq_ring_tx_clean(&ring[AQ_VEC_TX_ID]);
-				if (err < 0)
-					goto err_exit;
-				was_tx_cleaned = true;
-			}
+		for (n = 0U; self->rx_rings > n && *work_done < budget; ++n) {
+			int done = *work_done;
+
+			tc = (self->rx_next + n) % self->rx_rings;
+			ring = &self->ring[tc][AQ_VEC_RX_ID];
 
 			err = self->aq_hw_ops->hw_ring_rx_receive(self->aq_hw,
-					    &ring[AQ_VEC_RX_ID]);
+								  ring);
 			if (err < 0)
 				goto err_exit;
 
-			if (ring[AQ_VEC_RX_ID].sw_head !=
-				ring[AQ_VEC_RX_ID].hw_head) {
-				err = aq_ring_rx_clean(&ring[AQ_VEC_RX_ID],
-						       &work_done,
-						       budget - work_done);
-				if (err < 0)
-					goto err_exit;
-
-				sw_tail_old = ring[AQ_VEC_RX_ID].sw_tail;
-
-				err = aq_ring_rx_fill(&ring[AQ_VEC_RX_ID]);
-				if (err < 0)
-					goto err_exit;
-
-				err = self->aq_hw_ops->hw_ring_rx_fill(
-					self->aq_hw,
-					&ring[AQ_VEC_RX_ID], sw_tail_old);
-				if (err < 0)
-					goto err_exit;
+			if (ring->sw_head == ring->hw_head) {
+				ring->rx_deficit = 0;
+				__clear_bit(tc, &pending);
+				continue;
 			}
-		}
 
-		if (was_tx_cleaned)
-			work_done = budget;
+			ring->rx_deficit = min(ring->rx_deficit + quantum,
+					       budget);
+
+			err = aq_ring_rx_clean(ring, &self->napi, work_done,
+					       min(ring->rx_deficit,
+						   budget - *work_done));
+			if (err < 0)
+				goto err_exit;
+
+			ring->rx_deficit -= *work_done - done;
+			if (*work_done != done)
+				is_progress = true;
+
+			if (ring->sw_head != ring->hw_head)
+				__set_bit(tc, &pending);
+			else
+				__clear_bit(tc, &pending);
+
+			sw_tail_old = ring->sw_tail;
+
+			err = aq_ring_rx_fill(ring);
+			if (err < 0)
+				goto err_exit;
 
-		if (work_done < budget) {
-			napi_complete(napi);
-			self->aq_hw_ops->hw_irq_enable(self->aq_hw,
-					1U << self->aq_ring_param.vec_idx);
+			err = self->aq_hw_ops->hw_ring_rx_fill(self->aq_hw,
+							       ring,
+							       sw_tail_old);
+			if (err < 0)
+				goto err_exit;
 		}
+	}
+
+	/* Rings the budget ran out on, as seen by their last receive. A zero
+	 * budget (netpoll) allows no RX work, nothing is starved then.
+	 */
+	if (budget && *work_done >= budget)
+		for_each_set_bit(tc, &pending, self->rx_rings)
+			++self->ring[tc][AQ_VEC_RX_ID].stats.rx.starved;
+
+	self->rx_next = (self->rx_next + 1U) % self->rx_rings;
+
+err_exit:
+	return err;
+}
+
+/* Only rings with work are looked at. RX completion is an in-memory DD
+ * check. A TX ring costs a head register read, which is skipped when it
+ * has nothing in flight, or when only the RX interrupt of a vector with
+ * a TX interrupt of its own fired. A poll with no cause (busy polling)
+ * looks at everything.
+ *
+ * NAPI guarantees a single poller per vector, so the poll takes no vector
+ * wide lock. The only state shared with other contexts is TX reclaim,
+ * which aq_nic_xmit() may be doing inline; that is resolved per ring and
+ * never loses the wakeup.
+ */
+static int aq_vec_poll(struct napi_struct *napi, int budget)
+{
+	struct aq_vec_s *self = container_of(napi, struct aq_vec_s, napi);
+	struct aq_ring_s *ring = NULL;
+	int work_done = 0;
+	int err = 0;
+	unsigned int i = 0U;
+	unsigned long causes = xchg(&self->poll_causes, 0UL);
+	bool is_tx_cause = !causes || (causes & BIT(AQ_VEC_CAUSE_TX));
+	bool is_tx_pending = false;
+
+	++self->polls;
+
+	for (i = 0U, ring = self->ring[0];
+		is_tx_cause && self->tx_rings > i; ++i, ring = self->ring[i]) {
+		err = aq_vec_tx_poll(self, &ring[AQ_VEC_TX_ID], budget,
+				     &is_tx_pending);
+		if (err < 0)
+			goto err_exit;
+	}
+
+	if (is_tx_cause && self->xdp_ring.is_xdp) {
+		err = aq_vec_tx_poll(self, &self->xdp_ring, budget,
+				     &is_tx_pending);
+		if (err < 0)
+			goto err_exit;
+	}
+
+	err = aq_vec_rx_poll(self, budget, &work_done);
+
+	if (self->xdp_ring.is_xdp)
+		aq_vec_xdp_flush(self);
 
 err_exit:
-		spin_unlock(&self->header.lock);
+	/* TX work is not counted, but a TX backlog left over by
+	 * AQ_CFG_TX_CLEAN_BUDGET keeps the context scheduled. So does running
+	 * out of memory for RX, which the next poll retries. Other errors
+	 * (-ENXIO after surprise removal, -EIO) don't go away by polling:
+	 * the context completes and waits for the next interrupt.
+	 */
+	if (is_tx_pending || err == -ENOMEM) {
+		set_bit(AQ_VEC_CAUSE_TX, &self->poll_causes);
+		work_done = budget;
+	}
+
+	/* The core may defer the completion (busy polling), leave
+	 * the interrupt masked then.
+	 */
+	if (work_done < budget && napi_complete_done(napi, work_done) &&
+	    !self->is_polling) {
+		aq_vec_dim(self);
+
+		self->aq_hw_ops->hw_irq_enable(self->aq_hw,
+				BIT(self->aq_ring_param.vec_idx) |
+				BIT(self->aq_ring_param.tx_vec_idx));
+
+		/* An interrupt taken during this poll found the context
+		 * still scheduled, only its cause is left.
+		 */
+		if (READ_ONCE(self->poll_causes))
+			aq_vec_schedule(self, 0UL);
 	}
 
 	return work_done;
 }
 
+/* Threaded NAPI: the interrupt only marks the context scheduled and wakes
+ * this thread, which then owns it until aq_vec_poll() completes it.
+ */
+static int aq_vec_poll_thread(void *data)
+{
+	struct aq_vec_s *self = data;
+	int weight = self->napi.weight;
+	int work_done = 0;
+
+	for (;;) {
+		set_current_state(TASK_INTERRUPTIBLE);
+
+		if (kthread_should_stop())
+			break;
+
+		if (!test_and_clear_bit(AQ_VEC_POLL_PENDING,
+					&self->poll_flags)) {
+			schedule();
+			continue;
+		}
+
+		__set_current_state(TASK_RUNNING);
+
+		do {
+			local_bh_disable();
+			work_done = aq_vec_poll(&self->napi, weight);
+			if (work_done >= weight &&
+			    napi_disable_pending(&self->napi)) {
+				napi_complete(&self->napi);
+				work_done = 0;
+			}
+			local_bh_enable();
+
+			cond_resched();
+		} while (work_done >= weight);
+	}
+
+	__set_current_state(TASK_RUNNING);
+
+	return 0;
+}
+
+static void aq_vec_schedule(struct aq_vec_s *self, unsigned long causes)
+{
+	unsigned int bit = 0U;
+
+	for_each_set_bit(bit, &causes, BITS_PER_LONG)
+		set_bit(bit, &self->poll_causes);
+
+	if (!self->poll_thread) {
+		napi_schedule(&self->napi);
+	} else if (napi_schedule_prep(&self->napi)) {
+		set_bit(AQ_VEC_POLL_PENDING, &self->poll_flags);
+		wake_up_process(self->poll_thread);
+	}
+}
+
+/* Polling mode: stands in for the vector interrupt */
+static enum hrtimer_restart aq_vec_poll_timer_cb(struct hrtimer *timer)
+{
+	struct aq_vec_s *self = container_of(timer, struct aq_vec_s,
+					     poll_timer);
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(self->aq_nic);
+
+	aq_vec_schedule(self, 0UL);
+
+	hrtimer_forward_now(timer, us_to_ktime(cfg->polling_usecs));
+
+	return HRTIMER_RESTART;
+}
+
+/* NUMA node of the CPU servicing a vector, the device's node otherwise */
+static int aq_vec_cpu_to_node(struct aq_nic_s *aq_nic, unsigned int cpu)
+{
+	int node = NUMA_NO_NODE;
+
+	if (cpu < nr_cpu_ids && cpu_online(cpu))
+		node = cpu_to_node(cpu);
+
+	if (node == NUMA_NO_NODE)
+		node = dev_to_node(aq_nic_get_dev(aq_nic));
+
+	return node;
+}
+
+static int aq_vec_addr_to_node(const void *addr)
+{
+	return (addr && virt_addr_valid(addr)) ?
+		page_to_nid(virt_to_page(addr)) : NUMA_NO_NODE;
+}
+
+/* Moves the queue state of the vector to the CPUs in mask, so that XPS
+ * keeps sending from the CPUs that also process the completions.
+ */
+void aq_vec_set_affinity(struct aq_vec_s *self, const cpumask_t *mask)
+{
+	struct aq_ring_s *ring = NULL;
+	unsigned int i = 0U;
+
+	cpumask_copy(&self->aq_ring_param.affinity_mask, mask);
+	self->aq_ring_param.cpu = cpumask_first(mask);
+	self->aq_ring_param.numa_node =
+		aq_vec_cpu_to_node(self->aq_nic, self->aq_ring_param.cpu);
+
+	/* Rings stay where they are, new RX pages follow the vector */
+	for (i = 0U, ring = self->ring[0];
+		self->tx_rings > i; ++i, ring = self->ring[i]) {
+		ring[AQ_VEC_TX_ID].cpu = self->aq_ring_param.cpu;
+		ring[AQ_VEC_RX_ID].cpu = self->aq_ring_param.cpu;
+		ring[AQ_VEC_RX_ID].numa_node = self->aq_ring_param.numa_node;
+
+		if (self->aq_hw_ops && self->aq_hw_ops->hw_ring_cpu_set)
+			self->aq_hw_ops->hw_ring_cpu_set(self->aq_hw,
+							 &ring[AQ_VEC_TX_ID]);
+	}
+
+	if (self->xdp_ring.is_xdp) {
+		self->xdp_ring.cpu = self->aq_ring_param.cpu;
+
+		if (self->aq_hw_ops && self->aq_hw_ops->hw_ring_cpu_set)
+			self->aq_hw_ops->hw_ring_cpu_set(self->aq_hw,
+							 &self->xdp_ring);
+	}
+
+	if (self->poll_thread)
+		set_cpus_allowed_ptr(self->poll_thread, mask);
+
+	netif_set_xps_queue(aq_nic_get_ndev(self->aq_nic), mask,
+			    self->aq_ring_param.vec_idx);
+}
+
+/* Follows IRQ affinity changes made from userspace */
+static void aq_vec_affinity_notify(struct irq_affinity_notify *notify,
+				   const cpumask_t *mask)
+{
+	struct aq_vec_s *self = container_of(notify, struct aq_vec_s,
+					     affinity_notify);
+
+	/* Only recorded, aq_vec_update_affinity() applies it under rtnl */
+	spin_lock(&self->header.lock);
+	cpumask_copy(&self->affinity_pending, mask);
+	set_bit(AQ_VEC_AFFINITY, &self->poll_flags);
+	spin_unlock(&self->header.lock);
+}
+
+/* Applies an affinity recorded by aq_vec_affinity_notify(). Called from
+ * the service task with rtnl held, i.e. while the vector is started.
+ */
+void aq_vec_update_affinity(struct aq_vec_s *self)
+{
+	cpumask_var_t mask;
+
+	if (!test_bit(AQ_VEC_AFFINITY, &self->poll_flags))
+		return;
+
+	if (!zalloc_cpumask_var(&mask, GFP_KERNEL))
+		return;
+
+	spin_lock(&self->header.lock);
+	clear_bit(AQ_VEC_AFFINITY, &self->poll_flags);
+	cpumask_copy(mask, &self->affinity_pending);
+	spin_unlock(&self->header.lock);
+
+	if (!cpumask_empty(mask))
+		aq_vec_set_affinity(self, mask);
+
+	free_cpumask_var(mask);
+}
+
+/* Replaces the program of a vector already running XDP */
+void aq_vec_set_xdp_prog(struct aq_vec_s *self, struct bpf_prog *prog)
+{
+	struct aq_ring_s *ring = NULL;
+	unsigned int i = 0U;
+
+	for (i = 0U, ring = self->ring[0];
+		self->rx_rings > i; ++i, ring = self->ring[i])
+		WRITE_ONCE(ring[AQ_VEC_RX_ID].xdp_prog, prog);
+}
+
+struct aq_ring_s *aq_vec_get_xdp_ring(struct aq_vec_s *self)
+{
+	return self->xdp_ring.is_xdp ? &self->xdp_ring : NULL;
+}
+
+/* irq is the interrupt servicing TX completions when separate, else 0 */
+void aq_vec_set_tx_irq(struct aq_vec_s *self, int irq)
+{
+	self->tx_irq = irq;
+}
+
+/* Restarts dynamic moderation from the default profile and programs it on
+ * the next poll, e.g. after the static moderation was rewritten.
+ */
+void aq_vec_dim_reset(struct aq_vec_s *self)
+{
+	set_bit(AQ_VEC_DIM_RESET, &self->poll_flags);
+}
+
+/* The IRQ core drops its reference once the notifier is unregistered
+ * and no notification is queued anymore.
+ */
+static void aq_vec_affinity_release(struct kref *ref)
+{
+	struct aq_vec_s *self = container_of(ref, struct aq_vec_s,
+					     affinity_notify.kref);
+
+	complete(&self->affinity_released);
+}
+
 struct aq_vec_s *aq_vec_alloc(struct aq_nic_s *aq_nic, unsigned int idx,
 			      struct aq_nic_cfg_s *aq_nic_cfg)
 {
 	struct aq_vec_s *self = NULL;
 	struct aq_ring_s *ring = NULL;
+	unsigned int cpu = aq_nic_vec_cpu(aq_nic, idx);
+	int node = aq_vec_cpu_to_node(aq_nic, cpu);
 	unsigned int i = 0U;
 	int err = 0;
 
-	self = kzalloc(sizeof(*self), GFP_KERNEL);
+	self = kzalloc_node(sizeof(*self), GFP_KERNEL, node);
 	if (!self) {
 		err = -ENOMEM;
 		goto err_exit;
@@ -125,23 +589,36 @@ struct aq_vec_s *aq_vec_alloc(struct aq_nic_s *aq_nic, unsigned int idx,
 
 	self->aq_nic = aq_nic;
 	self->aq_ring_param.vec_idx = idx;
-	self->aq_ring_param.cpu =
-		idx + aq_nic_cfg->aq_rss.base_cpu_number;
+	self->aq_ring_param.tx_vec_idx = aq_nic_cfg->is_tx_irq_separate ?
+		aq_nic_cfg->vecs + idx : idx;
+	self->aq_ring_param.cpu = cpu;
+	self->aq_ring_param.numa_node = node;
 
 	cpumask_set_cpu(self->aq_ring_param.cpu,
 			&self->aq_ring_param.affinity_mask);
 
+	self->is_napi_threaded = aq_nic_cfg->is_napi_threaded;
+	self->is_polling = aq_nic_cfg->is_polling;
+
+	hrtimer_init(&self->poll_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	self->poll_timer.function = aq_vec_poll_timer_cb;
+
+	self->affinity_notify.notify = aq_vec_affinity_notify;
+	self->affinity_notify.release = aq_vec_affinity_release;
+	init_completion(&self->affinity_released);
+
 	self->tx_rings = 0;
 	self->rx_rings = 0;
 
 	netif_napi_add(aq_nic_get_ndev(aq_nic), &self->napi,
-		       aq_vec_poll, AQ_CFG_NAPI_WEIGHT);
+		       aq_vec_poll, aq_nic_cfg->napi_weight);
 
 	for (i = 0; i < aq_nic_cfg->tcs; ++i) {
 		unsigned int idx_ring = AQ_NIC_TCVEC2RING(self->nic,
 						self->tx_rings,
 						self->aq_ring_param.vec_idx);
 
+		self->ring[i][AQ_VEC_TX_ID].numa_node = node;
 		ring = aq_ring_tx_alloc(&self->ring[i][AQ_VEC_TX_ID], aq_nic,
 					idx_ring, aq_nic_cfg);
 		if (!ring) {
@@ -151,8 +628,10 @@ struct aq_vec_s *aq_vec_alloc(struct aq_nic_s *aq_nic, unsigned int idx,
 
 		++self->tx_rings;
 
+		ring->cpu = self->aq_ring_param.cpu;
 		aq_nic_set_tx_ring(aq_nic, idx_ring, ring);
 
+		self->ring[i][AQ_VEC_RX_ID].numa_node = node;
 		ring = aq_ring_rx_alloc(&self->ring[i][AQ_VEC_RX_ID], aq_nic,
 					idx_ring, aq_nic_cfg);
 		if (!ring) {
@@ -161,6 +640,25 @@ struct aq_vec_s *aq_vec_alloc(struct aq_nic_s *aq_nic, unsigned int idx,
 		}
 
 		++self->rx_rings;
+
+		ring->cpu = self->aq_ring_param.cpu;
+		ring->xdp_tx_ring = &self->xdp_ring;
+	}
+
+	if (aq_nic_get_xdp_prog(aq_nic)) {
+		self->xdp_ring.numa_node = node;
+		ring = aq_ring_tx_alloc(&self->xdp_ring, aq_nic,
+					AQ_NIC_VEC2XDPRING(
+						aq_nic_cfg->aq_hw_caps->vecs,
+						idx),
+					aq_nic_cfg);
+		if (!ring) {
+			err = -ENOMEM;
+			goto err_exit;
+		}
+
+		ring->cpu = self->aq_ring_param.cpu;
+		ring->is_xdp = true;
 	}
 
 err_exit:
@@ -215,6 +713,18 @@ int aq_vec_init(struct aq_vec_s *self, struct aq_hw_ops *aq_hw_ops,
 			goto err_exit;
 	}
 
+	if (self->xdp_ring.is_xdp) {
+		err = aq_ring_init(&self->xdp_ring);
+		if (err < 0)
+			goto err_exit;
+
+		err = self->aq_hw_ops->hw_ring_tx_init(self->aq_hw,
+						       &self->xdp_ring,
+						       &self->aq_ring_param);
+		if (err < 0)
+			goto err_exit;
+	}
+
 err_exit:
 	return err;
 }
@@ -238,8 +748,41 @@ int aq_vec_start(struct aq_vec_s *self)
 			goto err_exit;
 	}
 
+	if (self->xdp_ring.is_xdp) {
+		err = self->aq_hw_ops->hw_ring_tx_start(self->aq_hw,
+							&self->xdp_ring);
+		if (err < 0)
+			goto err_exit;
+	}
+
+	if (self->is_napi_threaded) {
+		struct task_struct *thread = NULL;
+
+		thread = kthread_create(aq_vec_poll_thread, self, "%s-napi%u",
+					aq_nic_get_ndev(self->aq_nic)->name,
+					self->aq_ring_param.vec_idx);
+		if (IS_ERR(thread)) {
+			err = PTR_ERR(thread);
+			goto err_exit;
+		}
+
+		/* Not bound: operators may move it with taskset/cgroups */
+		set_cpus_allowed_ptr(thread,
+				     &self->aq_ring_param.affinity_mask);
+		clear_bit(AQ_VEC_POLL_PENDING, &self->poll_flags);
+		self->poll_thread = thread;
+		wake_up_process(thread);
+	}
+
+	aq_vec_dim_reset(self);
 	napi_enable(&self->napi);
 
+	if (self->is_polling)
+		hrtimer_start(&self->poll_timer,
+			      us_to_ktime(aq_nic_get_cfg(self->aq_nic)->
+					  polling_usecs),
+			      HRTIMER_MODE_REL);
+
 err_exit:
 	return err;
 }
@@ -258,7 +801,28 @@ void aq_vec_stop(struct aq_vec_s *self)
 						 &ring[AQ_VEC_RX_ID]);
 	}
 
+	if (self->xdp_ring.is_xdp)
+		self->aq_hw_ops->hw_ring_tx_stop(self->aq_hw, &self->xdp_ring);
+
+	hrtimer_cancel(&self->poll_timer);
+
 	napi_disable(&self->napi);
+
+	if (self->poll_thread) {
+		kthread_stop(self->poll_thread);
+		self->poll_thread = NULL;
+	}
+
+	self->tx_irq = 0;
+
+	/* The IRQs are freed by now, but a notification still queued holds
+	 * the notifier and must be done before the vector can be freed.
+	 */
+	if (self->affinity_notify.irq) {
+		wait_for_completion(&self->affinity_released);
+		reinit_completion(&self->affinity_released);
+		self->affinity_notify.irq = 0;
+	}
 }
 
 void aq_vec_deinit(struct aq_vec_s *self)
@@ -274,6 +838,9 @@ void aq_vec_deinit(struct aq_vec_s *self)
 		aq_ring_tx_deinit(&ring[AQ_VEC_TX_ID]);
 		aq_ring_rx_deinit(&ring[AQ_VEC_RX_ID]);
 	}
+
+	if (self->xdp_ring.is_xdp)
+		aq_ring_tx_deinit(&self->xdp_ring);
 err_exit:;
 }
 
@@ -291,6 +858,9 @@ void aq_vec_free(struct aq_vec_s *self)
 		aq_ring_free(&ring[AQ_VEC_RX_ID]);
 	}
 
+	if (self->xdp_ring.is_xdp)
+		aq_ring_free(&self->xdp_ring);
+
 	netif_napi_del(&self->napi);
 
 	kfree(self);
@@ -301,13 +871,18 @@ err_exit:;
 irqreturn_t aq_vec_isr(int irq, void *private)
 {
 	struct aq_vec_s *self = private;
+	unsigned long causes = AQ_VEC_CAUSES_ALL;
 	int err = 0;
 
 	if (!self) {
 		err = -EINVAL;
 		goto err_exit;
 	}
-	napi_schedule(&self->napi);
+
+	if (self->tx_irq)
+		causes = (irq == self->tx_irq) ? BIT(AQ_VEC_CAUSE_TX) :
+						 BIT(AQ_VEC_CAUSE_RX);
+	aq_vec_schedule(self, causes);
 
 err_exit:
 	return err >= 0 ? IRQ_HANDLED : IRQ_NONE;
@@ -330,7 +905,7 @@ irqreturn_t aq_vec_isr_legacy(int irq, void *private)
 	if (irq_mask) {
 		self->aq_hw_ops->hw_irq_disable(self->aq_hw,
 			      1U << self->aq_ring_param.vec_idx);
-		napi_schedule(&self->napi);
+		aq_vec_schedule(self, AQ_VEC_CAUSES_ALL);
 	} else {
 		self->aq_hw_ops->hw_irq_enable(self->aq_hw, 1U);
 		err = IRQ_NONE;
@@ -340,11 +915,75 @@ err_exit:
 	return err >= 0 ? IRQ_HANDLED : IRQ_NONE;
 }
 
+void aq_vec_poll_show(struct aq_vec_s *self, struct seq_file *seq)
+{
+	struct aq_ring_s *ring = NULL;
+	unsigned int i = 0U;
+
+	for (i = 0U, ring = self->ring[0];
+		self->rx_rings > i; ++i, ring = self->ring[i])
+		seq_printf(seq, "%u\t%u\t%u\t%d\t%llu\n",
+			   ring[AQ_VEC_RX_ID].idx,
+			   self->aq_ring_param.vec_idx, i,
+			   ring[AQ_VEC_RX_ID].rx_deficit,
+			   ring[AQ_VEC_RX_ID].stats.rx.starved);
+}
+
+static void aq_vec_moderation_print(struct seq_file *seq, bool is_dim,
+				    struct aq_dim_s *dim, u32 itr)
+{
+	if (is_dim)
+		seq_printf(seq, "dim:%u", aq_dim_usecs(dim));
+	else if (itr == AQ_CFG_ITR_AUTO)
+		seq_puts(seq, "auto");
+	else
+		seq_printf(seq, "%u", itr);
+}
+
+/* Moderation class of the vector's queue: dynamic, fixed or by link speed */
+void aq_vec_moderation_show(struct aq_vec_s *self, struct seq_file *seq)
+{
+	struct aq_nic_cfg_s *cfg = aq_nic_get_cfg(self->aq_nic);
+	unsigned int idx = self->aq_ring_param.vec_idx;
+
+	seq_printf(seq, "%u\t", idx);
+	aq_vec_moderation_print(seq, cfg->rx_dim_mask & BIT(idx),
+				&self->rx_dim, cfg->rx_itr[idx]);
+	seq_puts(seq, "\t");
+	aq_vec_moderation_print(seq, cfg->tx_dim_mask & BIT(idx),
+				&self->tx_dim, cfg->tx_itr[idx]);
+	seq_puts(seq, "\n");
+}
+
+void aq_vec_numa_show(struct aq_vec_s *self, struct seq_file *seq)
+{
+	struct aq_ring_s *ring = NULL;
+	unsigned int i = 0U;
+
+	for (i = 0U, ring = self->ring[0];
+		self->tx_rings > i; ++i, ring = self->ring[i]) {
+		seq_printf(seq, "%u\t%u\t%u\t%d\t%d\t%d\t%d\t%d\n",
+			   ring[AQ_VEC_TX_ID].idx,
+			   self->aq_ring_param.vec_idx,
+			   self->aq_ring_param.cpu,
+			   self->aq_ring_param.numa_node,
+			   aq_vec_addr_to_node(self),
+			   aq_vec_addr_to_node(ring[AQ_VEC_TX_ID].dx_ring),
+			   aq_vec_addr_to_node(ring[AQ_VEC_RX_ID].dx_ring),
+			   aq_vec_addr_to_node(ring[AQ_VEC_RX_ID].buff_ring));
+	}
+}
+
 cpumask_t *aq_vec_get_affinity_mask(struct aq_vec_s *self)
 {
 	return &self->aq_ring_param.affinity_mask;
 }
 
+struct irq_affinity_notify *aq_vec_get_affinity_notify(struct aq_vec_s *self)
+{
+	return &self->affinity_notify;
+}
+
 void aq_vec_add_stats(struct aq_vec_s *self,
 		      struct aq_ring_stats_rx_s *stats_rx,
 		      struct aq_ring_stats_tx_s *stats_tx)
@@ -362,10 +1001,20 @@ void aq_vec_add_stats(struct aq_vec_s *self,
 		stats_rx->errors += rx->errors;
 		stats_rx->jumbo_packets += rx->jumbo_packets;
 		stats_rx->lro_packets += rx->lro_packets;
+		stats_rx->starved += rx->starved;
 
 		stats_tx->packets += tx->packets;
 		stats_tx->bytes += tx->bytes;
 		stats_tx->errors += tx->errors;
+		stats_tx->stops_avoided += tx->stops_avoided;
+		stats_tx->cross_cpu += tx->cross_cpu;
+		stats_tx->poll_contended += tx->poll_contended;
+	}
+
+	if (self->xdp_ring.is_xdp) {
+		stats_tx->packets += self->xdp_ring.stats.tx.packets;
+		stats_tx->bytes += self->xdp_ring.stats.tx.bytes;
+		stats_tx->errors += self->xdp_ring.stats.tx.errors;
 	}
 }
 
@@ -384,6 +1033,12 @@ int aq_vec_get_sw_stats(struct aq_vec_s *self, u64 *data, unsigned int *p_count)
 	data[++count] += stats_rx.jumbo_packets;
 	data[++count] += stats_rx.lro_packets;
 	data[++count] += stats_rx.errors;
+	data[++count] += stats_tx.stops_avoided;
+	data[++count] += stats_tx.cross_cpu;
+	data[++count] += stats_tx.poll_contended;
+	data[++count] += self->polls;
+	data[++count] += self->mmio_reads;
+	data[++count] += stats_rx.starved;
 
 	if (p_count)
 		*p_count = ++count;
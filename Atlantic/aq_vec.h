@@ -16,11 +16,14 @@
 
 #include "aq_common.h"
 #include <linux/irqreturn.h>
+#include <linux/interrupt.h>
 
 struct aq_hw_s;
 struct aq_hw_ops;
 struct aq_ring_stats_rx_s;
 struct aq_ring_stats_tx_s;
+struct seq_file;
+struct bpf_prog;
 
 irqreturn_t aq_vec_isr(int irq, void *private);
 irqreturn_t aq_vec_isr_legacy(int irq, void *private);
@@ -32,7 +35,17 @@ void aq_vec_deinit(struct aq_vec_s *self);
 void aq_vec_free(struct aq_vec_s *self);
 int aq_vec_start(struct aq_vec_s *self);
 void aq_vec_stop(struct aq_vec_s *self);
+void aq_vec_moderation_show(struct aq_vec_s *self, struct seq_file *seq);
+void aq_vec_numa_show(struct aq_vec_s *self, struct seq_file *seq);
+void aq_vec_set_xdp_prog(struct aq_vec_s *self, struct bpf_prog *prog);
+struct aq_ring_s *aq_vec_get_xdp_ring(struct aq_vec_s *self);
+void aq_vec_poll_show(struct aq_vec_s *self, struct seq_file *seq);
+void aq_vec_set_tx_irq(struct aq_vec_s *self, int irq);
+void aq_vec_dim_reset(struct aq_vec_s *self);
+void aq_vec_set_affinity(struct aq_vec_s *self, const cpumask_t *mask);
+void aq_vec_update_affinity(struct aq_vec_s *self);
 cpumask_t *aq_vec_get_affinity_mask(struct aq_vec_s *self);
+struct irq_affinity_notify *aq_vec_get_affinity_notify(struct aq_vec_s *self);
 int aq_vec_get_sw_stats(struct aq_vec_s *self, u64 *data,
 			unsigned int *p_count);
 void aq_vec_add_stats(struct aq_vec_s *self,
@@ -356,12 +356,22 @@ static int hw_atl_a0_hw_init(struct aq_hw_s *self,
 
 	itr_irq_auto_masklsw_set(self, aq_nic_cfg->aq_hw_caps->irq_mask);
 
-	/* Interrupts */
-	reg_gen_irq_map_set(self,
-			    ((HW_ATL_A0_ERR_INT << 0x18) | (1U << 0x1F)) |
-			    ((HW_ATL_A0_ERR_INT << 0x10) | (1U << 0x17)) |
-			    ((HW_ATL_A0_ERR_INT << 8) | (1U << 0xF)) |
-			    ((HW_ATL_A0_ERR_INT) | (1U << 0x7)), 0U);
+	/* Link/error interrupt goes to the vector after the ring vectors */
+	if (aq_nic_cfg->is_link_irq) {
+		u32 link_vec = aq_nic_cfg->link_irq_vec;
+
+		reg_gen_irq_map_set(self,
+				    ((link_vec << 0x18) | (1U << 0x1F)) |
+				    ((link_vec << 0x10) | (1U << 0x17)) |
+				    ((link_vec << 8) | (1U << 0xF)) |
+				    ((link_vec) | (1U << 0x7)), 0U);
+	} else {
+		reg_gen_irq_map_set(self,
+				    ((HW_ATL_A0_ERR_INT << 0x18) | (1U << 0x1F)) |
+				    ((HW_ATL_A0_ERR_INT << 0x10) | (1U << 0x17)) |
+				    ((HW_ATL_A0_ERR_INT << 8) | (1U << 0xF)) |
+				    ((HW_ATL_A0_ERR_INT) | (1U << 0x7)), 0U);
+	}
 
 	hw_atl_a0_hw_offload_set(self, aq_nic_cfg);
 
@@ -464,7 +474,6 @@ static int hw_atl_a0_hw_ring_tx_xmit(struct aq_hw_s *self,
 		ring->sw_tail = aq_ring_next_dx(ring, ring->sw_tail);
 	}
 
-	hw_atl_a0_hw_tx_ring_tail_update(self, ring);
 	return aq_hw_err_from_flags(self);
 }
 
@@ -530,7 +539,7 @@ static int hw_atl_a0_hw_ring_tx_init(struct aq_hw_s *self,
 	tdm_tx_desc_wr_wb_threshold_set(self, 0U, aq_ring->idx);
 
 	/* Mapping interrupt vector */
-	itr_irq_map_tx_set(self, aq_ring_param->vec_idx, aq_ring->idx);
+	itr_irq_map_tx_set(self, aq_ring_param->tx_vec_idx, aq_ring->idx);
 	itr_irq_map_en_tx_set(self, true, aq_ring->idx);
 
 	tdm_cpu_id_set(self, aq_ring_param->cpu, aq_ring->idx);
@@ -539,6 +548,15 @@ static int hw_atl_a0_hw_ring_tx_init(struct aq_hw_s *self,
 	return aq_hw_err_from_flags(self);
 }
 
+static int hw_atl_a0_hw_ring_cpu_set(struct aq_hw_s *self,
+				     struct aq_ring_s *aq_ring)
+{
+	tdm_cpu_id_set(self, aq_ring->cpu, aq_ring->idx);
+	rdm_cpu_id_set(self, aq_ring->cpu, aq_ring->idx);
+
+	return aq_hw_err_from_flags(self);
+}
+
 static int hw_atl_a0_hw_ring_rx_fill(struct aq_hw_s *self,
 				     struct aq_ring_s *ring,
 				     unsigned int sw_tail_old)
@@ -679,8 +697,11 @@ static int hw_atl_a0_hw_ring_rx_receive(struct aq_hw_s *self,
 
 static int hw_atl_a0_hw_irq_enable(struct aq_hw_s *self, u64 mask)
 {
-	itr_irq_msk_setlsw_set(self, LODWORD(mask) |
-			       (1U << HW_ATL_A0_ERR_INT));
+	/* With a link vector its bit is part of the caller's mask */
+	if (!self->aq_nic_cfg->is_link_irq)
+		mask |= BIT(HW_ATL_A0_ERR_INT);
+
+	itr_irq_msk_setlsw_set(self, LODWORD(mask));
 	return aq_hw_err_from_flags(self);
 }
 
@@ -766,52 +787,80 @@ err_exit:
 	return err;
 }
 
+/* The A0 throttles per interrupt: ring vectors first, then their TX
+ * vectors when separate. AQ_CFG_VECS_MAX for any other interrupt.
+ */
+static unsigned int hw_atl_a0_irq_vec(struct aq_nic_cfg_s *cfg,
+				      unsigned int irq)
+{
+	unsigned int vec = AQ_CFG_VECS_MAX;
+
+	if (irq < cfg->vecs)
+		vec = irq;
+	else if (cfg->is_tx_irq_separate && irq < 2U * cfg->vecs)
+		vec = irq - cfg->vecs;
+
+	return vec;
+}
+
 static int hw_atl_a0_hw_interrupt_moderation_set(struct aq_hw_s *self,
 						 bool itr_enabled)
 {
+	struct aq_nic_cfg_s *cfg = self->aq_nic_cfg;
+	bool is_auto = false;
 	unsigned int i = 0U;
 
-	if (itr_enabled && self->aq_nic_cfg->itr) {
-		if (self->aq_nic_cfg->itr != 0xFFFFU) {
-			u32 itr_ = (self->aq_nic_cfg->itr >> 1);
+	for (i = cfg->vecs; i--;)
+		if (cfg->rx_itr[i] == AQ_CFG_ITR_AUTO)
+			is_auto = true;
 
-			itr_ = min(AQ_CFG_IRQ_MASK, itr_);
+	/* A0 moderates RX only, tx_itr is not used */
+	if (itr_enabled && is_auto) {
+		u32 n = 0xFFFFU & aq_hw_read_reg(self, 0x00002A00U);
 
-			PHAL_ATLANTIC_A0->itr_rx = 0x80000000U |
-					(itr_ << 0x10);
-		} else  {
-			u32 n = 0xFFFFU & aq_hw_read_reg(self, 0x00002A00U);
-
-			if (n < self->aq_link_status.mbps) {
-				PHAL_ATLANTIC_A0->itr_rx = 0U;
-			} else {
-				static unsigned int hw_timers_tbl_[] = {
-					0x01CU, /* 10Gbit */
-					0x039U, /* 5Gbit */
-					0x039U, /* 5Gbit 5GS */
-					0x073U, /* 2.5Gbit */
-					0x120U, /* 1Gbit */
-					0x1FFU, /* 100Mbit */
-				};
-
-				unsigned int speed_index =
-					hw_atl_utils_mbps_2_speed_index(
-						self->aq_link_status.mbps);
-
-				PHAL_ATLANTIC_A0->itr_rx =
-					0x80000000U |
-					(hw_timers_tbl_[speed_index] << 0x10U);
-			}
-
-			aq_hw_write_reg(self, 0x00002A00U, 0x40000000U);
-			aq_hw_write_reg(self, 0x00002A00U, 0x8D000000U);
+		if (n < self->aq_link_status.mbps) {
+			PHAL_ATLANTIC_A0->itr_rx = 0U;
+		} else {
+			static unsigned int hw_timers_tbl_[] = {
+				0x01CU, /* 10Gbit */
+				0x039U, /* 5Gbit */
+				0x039U, /* 5Gbit 5GS */
+				0x073U, /* 2.5Gbit */
+				0x120U, /* 1Gbit */
+				0x1FFU, /* 100Mbit */
+			};
+
+			unsigned int speed_index =
+				hw_atl_utils_mbps_2_speed_index(
+					self->aq_link_status.mbps);
+
+			PHAL_ATLANTIC_A0->itr_rx =
+				0x80000000U |
+				(hw_timers_tbl_[speed_index] << 0x10U);
 		}
+
+		aq_hw_write_reg(self, 0x00002A00U, 0x40000000U);
+		aq_hw_write_reg(self, 0x00002A00U, 0x8D000000U);
 	} else {
 		PHAL_ATLANTIC_A0->itr_rx = 0U;
 	}
 
-	for (i = HW_ATL_A0_RINGS_MAX; i--;)
-		reg_irq_thr_set(self, PHAL_ATLANTIC_A0->itr_rx, i);
+	for (i = HW_ATL_A0_RINGS_MAX; i--;) {
+		unsigned int vec = hw_atl_a0_irq_vec(cfg, i);
+		u32 usecs = (vec < AQ_CFG_VECS_MAX) ?
+			    cfg->rx_itr[vec] : AQ_CFG_ITR_AUTO;
+		u32 itr_rx = PHAL_ATLANTIC_A0->itr_rx;
+
+		if (!itr_enabled || !usecs) {
+			itr_rx = 0U;
+		} else if (usecs != AQ_CFG_ITR_AUTO) {
+			u32 itr_ = min(AQ_CFG_IRQ_MASK, usecs >> 1);
+
+			itr_rx = 0x80000000U | (itr_ << 0x10);
+		}
+
+		reg_irq_thr_set(self, itr_rx, i);
+	}
 
 	return aq_hw_err_from_flags(self);
 }
@@ -869,6 +918,7 @@ static struct aq_hw_ops hw_atl_ops_ = {
 	.hw_stop              = hw_atl_a0_hw_stop,
 
 	.hw_ring_tx_xmit         = hw_atl_a0_hw_ring_tx_xmit,
+	.hw_ring_tx_tail_update  = hw_atl_a0_hw_tx_ring_tail_update,
 	.hw_ring_tx_head_update  = hw_atl_a0_hw_ring_tx_head_update,
 
 	.hw_ring_rx_receive      = hw_atl_a0_hw_ring_rx_receive,
@@ -880,6 +930,7 @@ static struct aq_hw_ops hw_atl_ops_ = {
 
 	.hw_ring_rx_init             = hw_atl_a0_hw_ring_rx_init,
 	.hw_ring_tx_init             = hw_atl_a0_hw_ring_tx_init,
+	.hw_ring_cpu_set             = hw_atl_a0_hw_ring_cpu_set,
 	.hw_packet_filter_set        = hw_atl_a0_hw_packet_filter_set,
 	.hw_multicast_list_set       = hw_atl_a0_hw_multicast_list_set,
 	.hw_interrupt_moderation_set = hw_atl_a0_hw_interrupt_moderation_set,
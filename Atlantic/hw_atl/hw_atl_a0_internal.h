@@ -126,6 +126,8 @@ static struct aq_hw_caps_s hw_atl_a0_hw_caps_ = {
 	.msix_irqs = 4U,
 	.irq_mask = ~0U,
 	.vecs = HW_ATL_A0_RSS_MAX,
+	.rss_max = HW_ATL_A0_RSS_MAX,
+	.rss_redirection_max = HW_ATL_A0_RSS_REDIRECTION_MAX,
 	.tcs = HW_ATL_A0_TC_MAX,
 	.rxd_alignment = 1U,
 	.rxd_size = HW_ATL_A0_RXD_SIZE,
@@ -396,10 +396,16 @@ static int hw_atl_b0_hw_init(struct aq_hw_s *self,
 
 	itr_irq_auto_masklsw_set(self, aq_nic_cfg->aq_hw_caps->irq_mask);
 
-	/* Interrupts */
-	reg_gen_irq_map_set(self,
-			    ((HW_ATL_B0_ERR_INT << 0x18) | (1U << 0x1F)) |
-			    ((HW_ATL_B0_ERR_INT << 0x10) | (1U << 0x17)), 0U);
+	/* Link/error interrupt goes to the vector after the ring vectors */
+	if (aq_nic_cfg->is_link_irq) {
+		u32 link_vec = aq_nic_cfg->link_irq_vec;
+
+		reg_gen_irq_map_set(self,
+				    ((link_vec << 0x18) | (1U << 0x1F)) |
+				    ((link_vec << 0x10) | (1U << 0x17)), 0U);
+	} else {
+		reg_gen_irq_map_set(self, 0U, 0U);
+	}
 
 	hw_atl_b0_hw_offload_set(self, aq_nic_cfg);
 
@@ -502,7 +508,6 @@ static int hw_atl_b0_hw_ring_tx_xmit(struct aq_hw_s *self,
 		ring->sw_tail = aq_ring_next_dx(ring, ring->sw_tail);
 	}
 
-	hw_atl_b0_hw_tx_ring_tail_update(self, ring);
 	return aq_hw_err_from_flags(self);
 }
 
@@ -568,7 +573,7 @@ static int hw_atl_b0_hw_ring_tx_init(struct aq_hw_s *self,
 	tdm_tx_desc_wr_wb_threshold_set(self, 0U, aq_ring->idx);
 
 	/* Mapping interrupt vector */
-	itr_irq_map_tx_set(self, aq_ring_param->vec_idx, aq_ring->idx);
+	itr_irq_map_tx_set(self, aq_ring_param->tx_vec_idx, aq_ring->idx);
 	itr_irq_map_en_tx_set(self, true, aq_ring->idx);
 
 	tdm_cpu_id_set(self, aq_ring_param->cpu, aq_ring->idx);
@@ -577,6 +582,15 @@ static int hw_atl_b0_hw_ring_tx_init(struct aq_hw_s *self,
 	return aq_hw_err_from_flags(self);
 }
 
+static int hw_atl_b0_hw_ring_cpu_set(struct aq_hw_s *self,
+				     struct aq_ring_s *aq_ring)
+{
+	tdm_cpu_id_set(self, aq_ring->cpu, aq_ring->idx);
+	rdm_cpu_id_set(self, aq_ring->cpu, aq_ring->idx);
+
+	return aq_hw_err_from_flags(self);
+}
+
 static int hw_atl_b0_hw_ring_rx_fill(struct aq_hw_s *self,
 				     struct aq_ring_s *ring,
 				     unsigned int sw_tail_old)
@@ -788,87 +802,138 @@ err_exit:
 	return err;
 }
 
+/* Vector a ring serves, AQ_CFG_VECS_MAX for unused rings. Data rings are
+ * laid out per TC with an AQ_CFG_TCS_MAX stride, XDP TX rings are taken
+ * from the top down, see AQ_NIC_TCVEC2RING() and AQ_NIC_VEC2XDPRING().
+ */
+static unsigned int hw_atl_b0_ring_vec(struct aq_nic_cfg_s *cfg,
+				       unsigned int ring)
+{
+	unsigned int vec = AQ_CFG_VECS_MAX;
+
+	if (cfg->tcs > 1U) {
+		if (ring < cfg->tcs * AQ_CFG_TCS_MAX &&
+		    ring % AQ_CFG_TCS_MAX < cfg->vecs)
+			vec = ring % AQ_CFG_TCS_MAX;
+	} else if (ring < cfg->vecs) {
+		vec = ring;
+	}
+
+	if (vec == AQ_CFG_VECS_MAX &&
+	    HW_ATL_B0_RINGS_MAX - 1U - ring < cfg->vecs)
+		vec = HW_ATL_B0_RINGS_MAX - 1U - ring;
+
+	return vec;
+}
+
+/* Moderation control word: enable, min and max timers in 2 us units */
+static u32 hw_atl_b0_itr_from_usecs(unsigned int usecs)
+{
+	u32 max_timer = min(0x1FFU, usecs / 2U);
+	u32 min_timer = min(0xFFU, usecs / 32U);
+
+	return 2U | (min_timer << 0x8U) | (max_timer << 0x10U);
+}
+
 static int hw_atl_b0_hw_interrupt_moderation_set(struct aq_hw_s *self,
 						 bool itr_enabled)
 {
+	struct aq_nic_cfg_s *cfg = self->aq_nic_cfg;
+	u32 itr_tx_auto = 0U;
+	u32 itr_rx_auto = 0U;
 	unsigned int i = 0U;
 
-	if (itr_enabled && self->aq_nic_cfg->itr) {
+	if (itr_enabled) {
+		static unsigned int hw_atl_b0_timers_table_tx_[][2] = {
+			{0xffU, 0xffU}, /* 10Gbit */
+			{0xffU, 0x1ffU}, /* 5Gbit */
+			{0xffU, 0x1ffU}, /* 5Gbit 5GS */
+			{0xffU, 0x1ffU}, /* 2.5Gbit */
+			{0xffU, 0x1ffU}, /* 1Gbit */
+			{0xffU, 0x1ffU}, /* 100Mbit */
+		};
+
+		static unsigned int hw_atl_b0_timers_table_rx_[][2] = {
+			{0x6U, 0x38U},/* 10Gbit */
+			{0xCU, 0x70U},/* 5Gbit */
+			{0xCU, 0x70U},/* 5Gbit 5GS */
+			{0x18U, 0xE0U},/* 2.5Gbit */
+			{0x30U, 0x80U},/* 1Gbit */
+			{0x4U, 0x50U},/* 100Mbit */
+		};
+
+		unsigned int speed_index =
+				hw_atl_utils_mbps_2_speed_index(
+					self->aq_link_status.mbps);
+
 		tdm_tx_desc_wr_wb_irq_en_set(self, 0U);
 		tdm_tdm_intr_moder_en_set(self, 1U);
 		rdm_rx_desc_wr_wb_irq_en_set(self, 0U);
 		rdm_rdm_intr_moder_en_set(self, 1U);
 
-		PHAL_ATLANTIC_B0->itr_tx = 2U;
-		PHAL_ATLANTIC_B0->itr_rx = 2U;
-
-		if (self->aq_nic_cfg->itr != 0xFFFFU) {
-			unsigned int max_timer = self->aq_nic_cfg->itr / 2U;
-			unsigned int min_timer = self->aq_nic_cfg->itr / 32U;
-
-			max_timer = min(0x1FFU, max_timer);
-			min_timer = min(0xFFU, min_timer);
-
-			PHAL_ATLANTIC_B0->itr_tx |= min_timer << 0x8U;
-			PHAL_ATLANTIC_B0->itr_tx |= max_timer << 0x10U;
-			PHAL_ATLANTIC_B0->itr_rx |= min_timer << 0x8U;
-			PHAL_ATLANTIC_B0->itr_rx |= max_timer << 0x10U;
-		} else {
-			static unsigned int hw_atl_b0_timers_table_tx_[][2] = {
-				{0xffU, 0xffU}, /* 10Gbit */
-				{0xffU, 0x1ffU}, /* 5Gbit */
-				{0xffU, 0x1ffU}, /* 5Gbit 5GS */
-				{0xffU, 0x1ffU}, /* 2.5Gbit */
-				{0xffU, 0x1ffU}, /* 1Gbit */
-				{0xffU, 0x1ffU}, /* 100Mbit */
-			};
-
-			static unsigned int hw_atl_b0_timers_table_rx_[][2] = {
-				{0x6U, 0x38U},/* 10Gbit */
-				{0xCU, 0x70U},/* 5Gbit */
-				{0xCU, 0x70U},/* 5Gbit 5GS */
-				{0x18U, 0xE0U},/* 2.5Gbit */
-				{0x30U, 0x80U},/* 1Gbit */
-				{0x4U, 0x50U},/* 100Mbit */
-			};
-
-			unsigned int speed_index =
-					hw_atl_utils_mbps_2_speed_index(
-						self->aq_link_status.mbps);
-
-			PHAL_ATLANTIC_B0->itr_tx |=
-				hw_atl_b0_timers_table_tx_[speed_index]
-				[0] << 0x8U; /* set min timer value */
-			PHAL_ATLANTIC_B0->itr_tx |=
-				hw_atl_b0_timers_table_tx_[speed_index]
-				[1] << 0x10U; /* set max timer value */
-
-			PHAL_ATLANTIC_B0->itr_rx |=
-				hw_atl_b0_timers_table_rx_[speed_index]
-				[0] << 0x8U; /* set min timer value */
-			PHAL_ATLANTIC_B0->itr_rx |=
-				hw_atl_b0_timers_table_rx_[speed_index]
-				[1] << 0x10U; /* set max timer value */
-		}
+		/* Timers for rings left on AQ_CFG_ITR_AUTO */
+		itr_tx_auto = 2U;
+		itr_tx_auto |=
+			hw_atl_b0_timers_table_tx_[speed_index]
+			[0] << 0x8U; /* set min timer value */
+		itr_tx_auto |=
+			hw_atl_b0_timers_table_tx_[speed_index]
+			[1] << 0x10U; /* set max timer value */
+
+		itr_rx_auto = 2U;
+		itr_rx_auto |=
+			hw_atl_b0_timers_table_rx_[speed_index]
+			[0] << 0x8U; /* set min timer value */
+		itr_rx_auto |=
+			hw_atl_b0_timers_table_rx_[speed_index]
+			[1] << 0x10U; /* set max timer value */
 	} else {
 		tdm_tx_desc_wr_wb_irq_en_set(self, 1U);
 		tdm_tdm_intr_moder_en_set(self, 0U);
 		rdm_rx_desc_wr_wb_irq_en_set(self, 1U);
 		rdm_rdm_intr_moder_en_set(self, 0U);
-		PHAL_ATLANTIC_B0->itr_tx = 0U;
-		PHAL_ATLANTIC_B0->itr_rx = 0U;
 	}
 
+	/* Per ring, so every vector keeps its own moderation class */
 	for (i = HW_ATL_B0_RINGS_MAX; i--;) {
-		reg_tx_intr_moder_ctrl_set(self,
-					   PHAL_ATLANTIC_B0->itr_tx, i);
-		reg_rx_intr_moder_ctrl_set(self,
-					   PHAL_ATLANTIC_B0->itr_rx, i);
+		unsigned int vec = hw_atl_b0_ring_vec(cfg, i);
+		u32 itr_tx = itr_tx_auto;
+		u32 itr_rx = itr_rx_auto;
+
+		if (itr_enabled && vec < AQ_CFG_VECS_MAX) {
+			if (cfg->tx_itr[vec] != AQ_CFG_ITR_AUTO)
+				itr_tx = hw_atl_b0_itr_from_usecs(
+							cfg->tx_itr[vec]);
+			if (cfg->rx_itr[vec] != AQ_CFG_ITR_AUTO)
+				itr_rx = hw_atl_b0_itr_from_usecs(
+							cfg->rx_itr[vec]);
+		}
+
+		reg_tx_intr_moder_ctrl_set(self, itr_tx, i);
+		reg_rx_intr_moder_ctrl_set(self, itr_rx, i);
 	}
 
 	return aq_hw_err_from_flags(self);
 }
 
+static int hw_atl_b0_hw_ring_rx_moderation_set(struct aq_hw_s *self,
+						struct aq_ring_s *aq_ring,
+						unsigned int usecs)
+{
+	reg_rx_intr_moder_ctrl_set(self, hw_atl_b0_itr_from_usecs(usecs),
+				   aq_ring->idx);
+	return aq_hw_err_from_flags(self);
+}
+
+static int hw_atl_b0_hw_ring_tx_moderation_set(struct aq_hw_s *self,
+						struct aq_ring_s *aq_ring,
+						unsigned int usecs)
+{
+	reg_tx_intr_moder_ctrl_set(self, hw_atl_b0_itr_from_usecs(usecs),
+				   aq_ring->idx);
+	return aq_hw_err_from_flags(self);
+}
+
 static int hw_atl_b0_hw_stop(struct aq_hw_s *self)
 {
 	hw_atl_b0_hw_irq_disable(self, HW_ATL_B0_INT_MASK);
@@ -922,6 +987,7 @@ static struct aq_hw_ops hw_atl_ops_ = {
 	.hw_stop              = hw_atl_b0_hw_stop,
 
 	.hw_ring_tx_xmit         = hw_atl_b0_hw_ring_tx_xmit,
+	.hw_ring_tx_tail_update  = hw_atl_b0_hw_tx_ring_tail_update,
 	.hw_ring_tx_head_update  = hw_atl_b0_hw_ring_tx_head_update,
 
 	.hw_ring_rx_receive      = hw_atl_b0_hw_ring_rx_receive,
@@ -933,9 +999,12 @@ static struct aq_hw_ops hw_atl_ops_ = {
 
 	.hw_ring_rx_init             = hw_atl_b0_hw_ring_rx_init,
 	.hw_ring_tx_init             = hw_atl_b0_hw_ring_tx_init,
+	.hw_ring_cpu_set             = hw_atl_b0_hw_ring_cpu_set,
 	.hw_packet_filter_set        = hw_atl_b0_hw_packet_filter_set,
 	.hw_multicast_list_set       = hw_atl_b0_hw_multicast_list_set,
 	.hw_interrupt_moderation_set = hw_atl_b0_hw_interrupt_moderation_set,
+	.hw_ring_rx_moderation_set   = hw_atl_b0_hw_ring_rx_moderation_set,
+	.hw_ring_tx_moderation_set   = hw_atl_b0_hw_ring_tx_moderation_set,
 	.hw_rss_set                  = hw_atl_b0_hw_rss_set,
 	.hw_rss_hash_set             = hw_atl_b0_hw_rss_hash_set,
 	.hw_get_regs                 = hw_atl_utils_hw_get_regs,
@@ -174,9 +174,11 @@ struct __packed hw_atl_rxd_wb_s {
 static struct aq_hw_caps_s hw_atl_b0_hw_caps_ = {
 	.ports = 1U,
 	.is_64_dma = true,
-	.msix_irqs = 4U,
+	.msix_irqs = HW_ATL_B0_RINGS_MAX,
 	.irq_mask = ~0U,
-	.vecs = HW_ATL_B0_RSS_MAX,
+	.vecs = HW_ATL_B0_RINGS_MAX,
+	.rss_max = HW_ATL_B0_RSS_MAX,
+	.rss_redirection_max = HW_ATL_B0_RSS_REDIRECTION_MAX,
 	.tcs = HW_ATL_B0_TC_MAX,
 	.rxd_alignment = 1U,
 	.rxd_size = HW_ATL_B0_RXD_SIZE,
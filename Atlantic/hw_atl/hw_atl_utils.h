@@ -126,7 +126,6 @@ struct __packed hw_atl_s {
 	struct aq_hw_s base;
 	struct hw_aq_atl_utils_mbox mbox;
 	u64 speed;
-	u32 itr_tx;
 	u32 itr_rx;
 	unsigned int chip_features;
 	u32 fw_ver_actual;